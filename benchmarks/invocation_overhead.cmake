@@ -0,0 +1,59 @@
+# Measures the fixed cost of one invocation: runs the checker RUNS times in a row on a tiny CSV
+# and reports the mean wall time per run, once with the progress display and once with --silent.
+#
+# Usage: cmake -DCHECKER=<binary> -DFIXTURE=<csv> [-DRUNS=200] -P invocation_overhead.cmake
+
+cmake_minimum_required(VERSION 3.23) # string(TIMESTAMP) with microseconds
+
+foreach(variable CHECKER FIXTURE)
+    if(NOT DEFINED ${variable})
+        message(FATAL_ERROR "${variable} is not set.")
+    endif()
+endforeach()
+if(NOT DEFINED RUNS)
+    set(RUNS 200)
+endif()
+
+# one reading, so a second boundary cannot fall between the seconds and their fraction; %f is
+# zero padded to six digits, which makes "%s%f" the time in whole microseconds
+function(microseconds_now outputVariable)
+    string(TIMESTAMP microseconds "%s%f" UTC)
+    set(${outputVariable} ${microseconds} PARENT_SCOPE)
+endfunction()
+
+file(SIZE "${FIXTURE}" fixtureSize)
+message(STATUS "${RUNS} sequential runs on ${FIXTURE} (${fixtureSize} bytes)")
+
+foreach(mode progress silent)
+    set(arguments --csv "${FIXTURE}" -b "1:2,3")
+    if(mode STREQUAL "silent")
+        list(APPEND arguments --silent)
+    endif()
+
+    set(totalMicroseconds 0)
+    set(slowestMicroseconds 0)
+    foreach(run RANGE 1 ${RUNS})
+        microseconds_now(startMicroseconds)
+        execute_process(
+            COMMAND "${CHECKER}" ${arguments}
+            RESULT_VARIABLE exitCode
+            OUTPUT_QUIET
+            ERROR_VARIABLE errorOutput
+        )
+        microseconds_now(endMicroseconds)
+
+        if(NOT exitCode EQUAL 0)
+            message(FATAL_ERROR "Run ${run} (${mode}) exited with ${exitCode}:\n${errorOutput}")
+        endif()
+
+        math(EXPR runMicroseconds "${endMicroseconds} - ${startMicroseconds}")
+        math(EXPR totalMicroseconds "${totalMicroseconds} + ${runMicroseconds}")
+        if(runMicroseconds GREATER slowestMicroseconds)
+            set(slowestMicroseconds ${runMicroseconds})
+        endif()
+    endforeach()
+
+    math(EXPR meanMicroseconds "${totalMicroseconds} / ${RUNS}")
+    math(EXPR totalMilliseconds "${totalMicroseconds} / 1000")
+    message(STATUS "${mode}: ${meanMicroseconds} us per run on average, ${slowestMicroseconds} us the slowest, ${totalMilliseconds} ms in total")
+endforeach()
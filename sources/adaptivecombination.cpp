@@ -0,0 +1,168 @@
+#include "adaptivecombination.hpp"
+
+#include <algorithm>
+#include <utility>
+
+namespace{
+
+    std::size_t countNodes(const RuleExpression::Node &node){
+        std::size_t nodeCount{1};
+        for(const RuleExpression::Node &operand : node.operands) nodeCount += countNodes(operand);
+        return nodeCount;
+    }
+
+    std::size_t maxOperandCount(const RuleExpression::Node &node){
+        std::size_t operandCount{node.operands.size()};
+        for(const RuleExpression::Node &operand : node.operands) operandCount = std::max(operandCount, maxOperandCount(operand));
+        return operandCount;
+    }
+
+} // namespace
+
+AdaptiveCombination::AdaptiveCombination(const RuleExpression &rule)
+    : plan_{rule.root()}
+    , columnOffsets_{rule.columnOffsets()}
+    , columnStatistics_(columnOffsets_.size())
+    , holdCounts_(maxOperandCount(rule.root()) + 1)
+    , nextHoldCounts_(maxOperandCount(rule.root()) + 1)
+{
+    estimates_.reserve(countNodes(plan_));
+    compile(); // leaves program_ and registers_ with the capacity every recompilation needs
+}
+
+void AdaptiveCombination::compile(){
+    program_.clear();
+    registers_.clear();
+
+    // compiled back to front, each instruction's successors are in place before it; reversing
+    // afterwards puts the entry at 0 and the instructions in the order they usually run in
+    compileNode(plan_, Accept, Reject);
+
+    std::reverse(program_.begin(), program_.end());
+    const std::uint32_t lastIndex{static_cast<std::uint32_t>(program_.size() - 1)};
+    for(Instruction &instruction : program_){
+        if(instruction.onTrue < Accept) instruction.onTrue = lastIndex - instruction.onTrue;
+        if(instruction.onFalse < Accept) instruction.onFalse = lastIndex - instruction.onFalse;
+    }
+}
+
+std::uint32_t AdaptiveCombination::compileNode(const RuleExpression::Node &node, std::uint32_t onTrue, std::uint32_t onFalse){
+    switch(node.kind){
+        case RuleExpression::Kind::FIELD:{
+            const auto slot{std::lower_bound(columnOffsets_.begin(), columnOffsets_.end(), node.columnOffset) - columnOffsets_.begin()};
+            return emit({Opcode::CHECK, node.columnOffset, 0, static_cast<std::uint32_t>(slot), onTrue, onFalse});
+        }
+        case RuleExpression::Kind::NOT:
+            return compileNode(node.operands.front(), onFalse, onTrue);
+        case RuleExpression::Kind::AND:{
+            std::uint32_t entry{onTrue};
+            for(auto operand{node.operands.rbegin()}; operand != node.operands.rend(); ++operand) entry = compileNode(*operand, entry, onFalse);
+            return entry;
+        }
+        case RuleExpression::Kind::OR:{
+            std::uint32_t entry{onFalse};
+            for(auto operand{node.operands.rbegin()}; operand != node.operands.rend(); ++operand) entry = compileNode(*operand, onTrue, entry);
+            return entry;
+        }
+        case RuleExpression::Kind::AT_LEAST:{
+            const int registerIndex{static_cast<int>(registers_.size())};
+            registers_.push_back(0);
+
+            // after operand i, a hold counts and accepts once there are enough, and a miss rejects
+            // once the operands left cannot make up for it
+            const int operandCount{static_cast<int>(node.operands.size())};
+            std::uint32_t next{onFalse};
+            for(int index{operandCount - 1}; index >= 0; --index){
+                const int operandsLeft{operandCount - 1 - index};
+                const std::uint32_t counted{emit({Opcode::COUNT, registerIndex, node.minimumCount, 0, onTrue, next})};
+                const int stillNeeded{node.minimumCount - operandsLeft};
+                const std::uint32_t missed{operandsLeft == 0 ? onFalse
+                                           : stillNeeded <= 0 ? next
+                                           : emit({Opcode::REQUIRE, registerIndex, stillNeeded, 0, next, onFalse})};
+                next = compileNode(node.operands[index], counted, missed);
+            }
+            return emit({Opcode::RESET, registerIndex, 0, 0, next, next});
+        }
+    }
+    return onFalse;
+}
+
+std::uint32_t AdaptiveCombination::emit(const Instruction &instruction){
+    program_.push_back(instruction);
+    return static_cast<std::uint32_t>(program_.size() - 1);
+}
+
+AdaptiveCombination::Estimate AdaptiveCombination::reorderNode(RuleExpression::Node &node){
+    switch(node.kind){
+        case RuleExpression::Kind::FIELD:{
+            // the +1 and +2 keep rarely reached fields from being judged on a handful of rows
+            const auto slot{std::lower_bound(columnOffsets_.begin(), columnOffsets_.end(), node.columnOffset) - columnOffsets_.begin()};
+            const ColumnStatistics &statistics{columnStatistics_[slot]};
+            return {(statistics.validCount + 1.0) / (statistics.checks + 2.0), 1.0};
+        }
+        case RuleExpression::Kind::NOT:{
+            const Estimate operand{reorderNode(node.operands.front())};
+            return {1.0 - operand.probability, operand.cost};
+        }
+        case RuleExpression::Kind::AND:
+        case RuleExpression::Kind::OR:
+        case RuleExpression::Kind::AT_LEAST:
+            break;
+    }
+
+    // the operands' own operands are estimated and popped again before the next one is pushed
+    const std::size_t firstEstimate{estimates_.size()};
+    for(RuleExpression::Node &operand : node.operands) estimates_.push_back(reorderNode(operand));
+    Estimate *const estimates{estimates_.data() + firstEstimate};
+
+    // an AND stops at the first miss, an OR at the first hold; an atleast is closer to one or the other
+    const int operandCount{static_cast<int>(node.operands.size())};
+    const bool isDecidedByMisses{node.kind == RuleExpression::Kind::AND || (node.kind == RuleExpression::Kind::AT_LEAST && node.minimumCount * 2 > operandCount)};
+    const auto urgency{[isDecidedByMisses](const Estimate &estimate){
+        return (isDecidedByMisses ? 1.0 - estimate.probability : estimate.probability) / estimate.cost;
+    }};
+
+    // insertion sort, stable and in place; operands are few
+    for(int index{1}; index < operandCount; ++index){
+        for(int position{index}; position > 0 && urgency(estimates[position]) > urgency(estimates[position - 1]); --position){
+            std::swap(node.operands[position], node.operands[position - 1]);
+            std::swap(estimates[position], estimates[position - 1]);
+        }
+    }
+
+    // the chance of each number of holds among the operands checked so far, over the rows still undecided
+    const int minimumCount{node.kind == RuleExpression::Kind::AND ? operandCount : node.kind == RuleExpression::Kind::OR ? 1 : node.minimumCount};
+    std::fill_n(holdCounts_.begin(), minimumCount + 1, 0.0);
+    holdCounts_[0] = 1.0;
+    Estimate estimate{0.0, 0.0};
+    for(int index{0}; index < operandCount; ++index){
+        const Estimate &operand{estimates[index]};
+        const int operandsLeft{operandCount - 1 - index};
+
+        std::fill_n(nextHoldCounts_.begin(), minimumCount + 1, 0.0);
+        for(int count{0}; count < minimumCount; ++count){
+            if(holdCounts_[count] == 0.0) continue;
+            estimate.cost += holdCounts_[count] * operand.cost;
+            nextHoldCounts_[count + 1] += holdCounts_[count] * operand.probability;
+            if(count + operandsLeft >= minimumCount) nextHoldCounts_[count] += holdCounts_[count] * (1.0 - operand.probability);
+        }
+        estimate.probability += nextHoldCounts_[minimumCount];
+        nextHoldCounts_[minimumCount] = 0.0;
+        holdCounts_.swap(nextHoldCounts_);
+    }
+
+    estimates_.resize(firstEstimate);
+    return estimate;
+}
+
+void AdaptiveCombination::reorder(){
+    rowsSinceReorder_ = 0;
+
+    reorderNode(plan_);
+    compile();
+
+    for(ColumnStatistics &statistics : columnStatistics_){
+        statistics.checks /= 2;
+        statistics.validCount /= 2;
+    }
+}
@@ -0,0 +1,122 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "constants.hpp"
+#include "ruleexpression.hpp"
+
+// Evaluates a combination's rule per row as a small compiled program, and recompiles it as rows go
+// by so that short-circuiting follows the data instead of the order the rule was written in.
+//
+// The program is a list of instructions with a true and a false successor each, the way a
+// compiler lowers && and ||: a field check jumps on to whatever decides the rule next, a negation
+// costs nothing because it just swaps the successors, and atleast(k, ...) counts its satisfied
+// operands in a register. Every rule runs without recursion or a stack, checking each field at
+// most once per occurrence and only while the outcome is still open.
+//
+// Each column counts how often it was checked and found valid. Every ClauseReorderInterval rows
+// the operands of each AND are sorted so the ones likely to fail and cheap to check come first,
+// the operands of each OR and atleast so the ones likely to hold come first, with the chances
+// estimated from those counts as if the columns were independent. The counts are halved
+// afterwards, so the order keeps up with data that changes through the file.
+//
+// Reordering runs on the scanning thread, so it works in buffers sized by the constructor and
+// allocates nothing: a recompiled program has as many instructions as the first one.
+//
+// Reordering never changes a result: the operands of AND, OR and atleast commute, and a cell's
+// validity does not depend on the cells checked before it.
+class AdaptiveCombination{
+public:
+    explicit AdaptiveCombination(const RuleExpression &rule);
+
+    template<typename CellValidity>
+    bool evaluate(const CellValidity &isCellValidAt){
+        if(++rowsSinceReorder_ == Constants::ClauseReorderInterval) reorder();
+
+        std::uint32_t programCounter{0};
+        while(true){
+            const Instruction &instruction{program_[programCounter]};
+
+            switch(instruction.opcode){
+                case Opcode::CHECK:{
+                    ColumnStatistics &statistics{columnStatistics_[instruction.statisticsSlot]};
+                    statistics.checks += 1;
+                    const bool isValid{isCellValidAt(instruction.operand)};
+                    statistics.validCount += isValid;
+                    programCounter = isValid ? instruction.onTrue : instruction.onFalse;
+                    break;
+                }
+                case Opcode::RESET:
+                    registers_[instruction.operand] = 0;
+                    programCounter = instruction.onTrue;
+                    break;
+                case Opcode::COUNT:
+                    programCounter = ++registers_[instruction.operand] >= instruction.threshold ? instruction.onTrue : instruction.onFalse;
+                    break;
+                case Opcode::REQUIRE:
+                    programCounter = registers_[instruction.operand] >= instruction.threshold ? instruction.onTrue : instruction.onFalse;
+                    break;
+            }
+
+            if(programCounter >= Accept) return programCounter == Accept;
+        }
+    }
+
+    RuleExpression order() const{ return RuleExpression{plan_}; } // the rule with its operands in the order they are checked now
+    std::size_t instructionCount() const{ return program_.size(); }
+
+private:
+    enum class Opcode : std::uint8_t{
+        CHECK,   // is the cell at column operand valid
+        RESET,   // zero register operand, then go on to onTrue
+        COUNT,   // increment register operand, has it reached threshold
+        REQUIRE  // has register operand reached threshold
+    };
+
+    struct Instruction{
+        Opcode opcode;
+        int operand;                  // column offset or register
+        int threshold{0};
+        std::uint32_t statisticsSlot{0};
+        std::uint32_t onTrue;
+        std::uint32_t onFalse;
+    };
+
+    // halved at every reorder, so they stay below twice the interval
+    struct ColumnStatistics{
+        std::uint32_t checks{0};
+        std::uint32_t validCount{0};
+    };
+
+    static constexpr std::uint32_t Accept{0xfffffffe};
+    static constexpr std::uint32_t Reject{0xffffffff};
+
+    void compile();
+    std::uint32_t compileNode(const RuleExpression::Node &node, std::uint32_t onTrue, std::uint32_t onFalse);
+    std::uint32_t emit(const Instruction &instruction);
+
+    struct Estimate{
+        double probability; // that the node holds
+        double cost;        // expected field checks
+    };
+    Estimate reorderNode(RuleExpression::Node &node);
+    void reorder();
+
+private:
+    RuleExpression::Node plan_; // the rule in its current order
+
+    std::vector<Instruction> program_; // starts at 0
+    std::vector<int> registers_;       // one per atleast
+
+    std::vector<int> columnOffsets_; // of the statistics slots
+    std::vector<ColumnStatistics> columnStatistics_;
+    std::size_t rowsSinceReorder_{0};
+
+    // reorder scratch: the estimates of the operands being sorted, nested as the tree is walked, and
+    // two rows of the chances of each number of holds
+    std::vector<Estimate> estimates_;
+    std::vector<double> holdCounts_;
+    std::vector<double> nextHoldCounts_;
+};
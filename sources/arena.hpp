@@ -0,0 +1,63 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+#include "constants.hpp"
+
+// Append-only storage for strings that must outlive the row buffer they were read from.
+// Strings are packed back to back into large blocks, so storing millions of short keys
+// costs one allocation per block instead of one per key. Returned views stay valid for
+// the lifetime of the arena.
+class StringArena{
+public:
+    explicit StringArena(std::size_t blockSize = Constants::ArenaBlockSize) : blockSize_{blockSize}{}
+
+    StringArena(const StringArena &) = delete;
+    StringArena &operator=(const StringArena &) = delete;
+    StringArena(StringArena &&) = default;
+    StringArena &operator=(StringArena &&) = default;
+
+    std::string_view store(std::string_view value){
+        if(value.empty()) return {};
+
+        if(value.size() > blockSize_){
+            // oversized values get a dedicated block in front of the one being filled
+            auto dedicatedBlock{std::make_unique<char[]>(value.size())};
+            std::memcpy(dedicatedBlock.get(), value.data(), value.size());
+            const std::string_view stored{dedicatedBlock.get(), value.size()};
+            blocks_.insert(blocks_.empty() ? blocks_.end() : blocks_.end() - 1, std::move(dedicatedBlock));
+            bytesReserved_ += value.size();
+            return stored;
+        }
+
+        if(blocks_.empty() || value.size() > blockSize_ - blockUsed_){
+            blocks_.push_back(std::make_unique<char[]>(blockSize_));
+            bytesReserved_ += blockSize_;
+            blockUsed_ = 0;
+        }
+
+        char *destination{blocks_.back().get() + blockUsed_};
+        std::memcpy(destination, value.data(), value.size());
+        blockUsed_ += value.size();
+        return {destination, value.size()};
+    }
+
+    void clear(){
+        blocks_.clear();
+        blockUsed_ = 0;
+        bytesReserved_ = 0;
+    }
+
+    std::size_t bytesReserved() const{ return bytesReserved_; }
+
+private:
+    std::size_t blockSize_;
+    std::size_t blockUsed_{0};
+    std::size_t bytesReserved_{0};
+    std::vector<std::unique_ptr<char[]>> blocks_;
+};
@@ -0,0 +1,371 @@
+#include "blockreader.hpp"
+
+#include <fmt/core.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <thread>
+
+#if defined(__linux__)
+    #include <atomic>
+    #include <cstdint>
+
+    #include <fcntl.h>
+    #include <linux/io_uring.h>
+    #include <sys/mman.h>
+    #include <sys/syscall.h>
+    #include <sys/uio.h>
+    #include <unistd.h>
+#endif
+
+#include "constants.hpp"
+#include "throttle.hpp"
+
+void BlockReader::AlignedDelete::operator()(char *buffer) const{
+    ::operator delete[](buffer, std::align_val_t{Constants::CopyBufferAlignment});
+}
+
+#if defined(__linux__)
+
+// The rings are driven through the raw system calls, which keeps liburing out of the build.
+struct BlockReader::IoUring{
+    int ringDescriptor{-1};
+
+    void *submissionRing{MAP_FAILED};
+    std::size_t submissionRingSize{0};
+    void *completionRing{MAP_FAILED}; // the same mapping as submissionRing on kernels with IORING_FEAT_SINGLE_MMAP
+    std::size_t completionRingSize{0};
+    io_uring_sqe *submissionEntries{static_cast<io_uring_sqe *>(MAP_FAILED)};
+    std::size_t submissionEntriesSize{0};
+
+    unsigned *submissionTail{nullptr};
+    unsigned *submissionMask{nullptr};
+    unsigned *submissionArray{nullptr};
+    unsigned *completionHead{nullptr};
+    unsigned *completionTail{nullptr};
+    unsigned *completionMask{nullptr};
+    io_uring_cqe *completionEntries{nullptr};
+
+    std::vector<iovec> bufferVectors; // one per slot
+    bool registeredBuffers{false};    // reads go to the fixed buffers, else through bufferVectors
+
+    ~IoUring(){
+        if(submissionEntries != MAP_FAILED) ::munmap(submissionEntries, submissionEntriesSize);
+        if(completionRing != MAP_FAILED && completionRing != submissionRing) ::munmap(completionRing, completionRingSize);
+        if(submissionRing != MAP_FAILED) ::munmap(submissionRing, submissionRingSize);
+        if(ringDescriptor >= 0) ::close(ringDescriptor);
+    }
+
+    int enter(unsigned submitCount, unsigned waitCount) const{
+        const unsigned flags{waitCount > 0 ? static_cast<unsigned>(IORING_ENTER_GETEVENTS) : 0u};
+        return static_cast<int>(::syscall(__NR_io_uring_enter, ringDescriptor, submitCount, waitCount, flags, nullptr, 0));
+    }
+};
+
+namespace{
+
+    template<typename Pointee>
+    Pointee *ringField(void *ring, unsigned offset){
+        return reinterpret_cast<Pointee *>(static_cast<char *>(ring) + offset);
+    }
+
+} // namespace
+
+#else
+
+struct BlockReader::IoUring{};
+
+#endif
+
+BlockReader::BlockReader(const std::string &filePath, bool directIo, ScanThrottle *throttle)
+    : filePath_{filePath}
+    , throttle_{throttle}
+{
+    std::size_t slotCount{1};
+
+#if defined(__linux__)
+    if(directIo){
+        fileDescriptor_ = ::open(filePath.c_str(), O_RDONLY | O_CLOEXEC | O_DIRECT);
+        directIo_ = fileDescriptor_ >= 0; // some file systems (tmpfs) refuse it, those are read through the page cache
+    }
+    if(fileDescriptor_ < 0) fileDescriptor_ = ::open(filePath.c_str(), O_RDONLY | O_CLOEXEC);
+    if(fileDescriptor_ < 0){
+        throw std::runtime_error{fmt::format("Could not open '{}'. {}", filePath, std::strerror(errno))};
+    }
+
+    io_uring_params parameters{};
+    const int ringDescriptor{static_cast<int>(::syscall(__NR_io_uring_setup, static_cast<unsigned>(Constants::AsyncReadQueueDepth), &parameters))};
+    if(ringDescriptor >= 0){
+        auto ring{std::make_unique<IoUring>()};
+        ring->ringDescriptor = ringDescriptor;
+
+        ring->submissionRingSize = parameters.sq_off.array + parameters.sq_entries * sizeof(unsigned);
+        ring->completionRingSize = parameters.cq_off.cqes + parameters.cq_entries * sizeof(io_uring_cqe);
+        const bool singleMapping{(parameters.features & IORING_FEAT_SINGLE_MMAP) != 0};
+        if(singleMapping){
+            ring->submissionRingSize = ring->completionRingSize = std::max(ring->submissionRingSize, ring->completionRingSize);
+        }
+
+        ring->submissionRing = ::mmap(
+            nullptr, ring->submissionRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringDescriptor, IORING_OFF_SQ_RING
+        );
+        ring->completionRing = singleMapping ? ring->submissionRing : ::mmap(
+            nullptr, ring->completionRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringDescriptor, IORING_OFF_CQ_RING
+        );
+        ring->submissionEntriesSize = parameters.sq_entries * sizeof(io_uring_sqe);
+        ring->submissionEntries = static_cast<io_uring_sqe *>(::mmap(
+            nullptr, ring->submissionEntriesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringDescriptor, IORING_OFF_SQES
+        ));
+
+        if(ring->submissionRing != MAP_FAILED && ring->completionRing != MAP_FAILED && ring->submissionEntries != MAP_FAILED){
+            ring->submissionTail = ringField<unsigned>(ring->submissionRing, parameters.sq_off.tail);
+            ring->submissionMask = ringField<unsigned>(ring->submissionRing, parameters.sq_off.ring_mask);
+            ring->submissionArray = ringField<unsigned>(ring->submissionRing, parameters.sq_off.array);
+            ring->completionHead = ringField<unsigned>(ring->completionRing, parameters.cq_off.head);
+            ring->completionTail = ringField<unsigned>(ring->completionRing, parameters.cq_off.tail);
+            ring->completionMask = ringField<unsigned>(ring->completionRing, parameters.cq_off.ring_mask);
+            ring->completionEntries = ringField<io_uring_cqe>(ring->completionRing, parameters.cq_off.cqes);
+
+            ring_ = std::move(ring);
+            slotCount = Constants::AsyncReadQueueDepth;
+        }
+    }
+#else
+    static_cast<void>(directIo); // there is no portable way to ask for it
+    file_.reset(std::fopen(filePath.c_str(), "rb"));
+    if(!file_){
+        throw std::runtime_error{fmt::format("Could not open '{}'. {}", filePath, std::strerror(errno))};
+    }
+
+    // the blocks already batch reads, stdio buffering on top would only add a copy
+    std::setvbuf(file_.get(), nullptr, _IONBF, 0);
+#endif
+
+    bufferPool_.reset(new(std::align_val_t{Constants::CopyBufferAlignment}) char[slotCount * Constants::RecordReaderBufferSize]);
+    for(std::size_t slotIndex{0}; slotIndex < slotCount; slotIndex++){
+        slots_.push_back(Slot{bufferPool_.get() + slotIndex * Constants::RecordReaderBufferSize});
+    }
+
+#if defined(__linux__)
+    if(ring_){
+        for(const Slot &slot : slots_) ring_->bufferVectors.push_back(iovec{slot.buffer, Constants::RecordReaderBufferSize});
+
+        // pinning the pool saves the kernel mapping it on every read, but counts against RLIMIT_MEMLOCK
+        // on older kernels; without it the same buffers are read into as plain vectors
+        ring_->registeredBuffers = ::syscall(
+            __NR_io_uring_register, ring_->ringDescriptor, IORING_REGISTER_BUFFERS,
+            ring_->bufferVectors.data(), static_cast<unsigned>(ring_->bufferVectors.size())
+        ) == 0;
+    }
+#endif
+}
+
+BlockReader::~BlockReader(){
+#if defined(__linux__)
+    if(ring_){
+        try{
+            drainReads(); // the kernel may still be writing into the pool
+        }catch(const std::exception &){
+            // nothing left to do about it, closing the ring cancels what is still queued
+        }
+        ring_.reset();
+    }
+    if(fileDescriptor_ >= 0) ::close(fileDescriptor_);
+#endif
+}
+
+BlockReader::Block BlockReader::next(){
+    const Block block{readNext()};
+    if(throttle_ != nullptr) throttle_->charge(block.size);
+    return block;
+}
+
+BlockReader::Block BlockReader::readNext(){
+    if(ring_){
+        submitReads();
+
+        Slot &slot{slots_[headSlot_]};
+        awaitSlot(slot);
+        headSlot_ = (headSlot_ + 1) % slots_.size();
+        pendingCount_ -= 1;
+        return deliver(slot);
+    }
+
+    Slot &slot{slots_.front()};
+    slot.fileOffset = nextReadOffset_;
+    slot.result = readBlocking(slot);
+    nextReadOffset_ += static_cast<long long int>(Constants::RecordReaderBufferSize);
+    return deliver(slot);
+}
+
+void BlockReader::seek(long long int fileOffset){
+    if(ring_) drainReads();
+    restartAt(fileOffset);
+}
+
+BlockReader::Block BlockReader::deliver(Slot &slot){
+    if(slot.result < 0){
+        throw std::runtime_error{fmt::format("Failed to read '{}'. {}", filePath_, std::strerror(-slot.result))};
+    }
+
+    const std::size_t readSize{static_cast<std::size_t>(slot.result)};
+    const std::size_t skippedBytes{skipBytes_};
+    skipBytes_ = 0;
+
+    const Block block{
+        slot.buffer + std::min(skippedBytes, readSize),
+        readSize > skippedBytes ? readSize - skippedBytes : 0,
+        slot.fileOffset + static_cast<long long int>(skippedBytes)
+    };
+
+    // the end of the file for now: the reads queued behind this one found nothing or raced a writer,
+    // so they are dropped and the next call reads on from where this one stopped
+    if(readSize < Constants::RecordReaderBufferSize){
+        if(ring_) drainReads();
+        restartAt(block.fileOffset + static_cast<long long int>(block.size));
+    }
+    return block;
+}
+
+void BlockReader::restartAt(long long int fileOffset){
+    const long long int alignment{directIo_ ? static_cast<long long int>(Constants::CopyBufferAlignment) : 1};
+    nextReadOffset_ = fileOffset - fileOffset % alignment;
+    skipBytes_ = static_cast<std::size_t>(fileOffset - nextReadOffset_);
+}
+
+int BlockReader::readBlocking(Slot &slot){
+#if defined(__linux__)
+    while(true){
+        const ssize_t readSize{::pread(fileDescriptor_, slot.buffer, Constants::RecordReaderBufferSize, static_cast<off_t>(slot.fileOffset))};
+        if(readSize >= 0) return static_cast<int>(readSize);
+        if(errno != EINTR) return -errno;
+    }
+#else
+    std::clearerr(file_.get()); // the end of file flag is sticky, but a followed file may have grown
+    if(std::fseek(file_.get(), static_cast<long>(slot.fileOffset), SEEK_SET) != 0) return -errno;
+
+    const std::size_t readSize{std::fread(slot.buffer, 1, Constants::RecordReaderBufferSize, file_.get())};
+    if(readSize == 0 && std::ferror(file_.get())) return -EIO;
+    return static_cast<int>(readSize);
+#endif
+}
+
+#if defined(__linux__)
+
+void BlockReader::submitReads(){
+    const std::size_t slotCount{slots_.size()};
+    unsigned submissionTail{*ring_->submissionTail}; // only ever written from here
+    unsigned preparedCount{0};
+
+    while(pendingCount_ + preparedCount < slotCount){
+        const std::size_t slotIndex{(headSlot_ + pendingCount_ + preparedCount) % slotCount};
+        Slot &slot{slots_[slotIndex]};
+        slot.fileOffset = nextReadOffset_ + static_cast<long long int>(preparedCount * Constants::RecordReaderBufferSize);
+
+        const unsigned entryIndex{submissionTail & *ring_->submissionMask};
+        io_uring_sqe &entry{ring_->submissionEntries[entryIndex]};
+        std::memset(&entry, 0, sizeof(entry));
+        entry.fd = fileDescriptor_;
+        entry.off = static_cast<std::uint64_t>(slot.fileOffset);
+        entry.user_data = slotIndex;
+        if(ring_->registeredBuffers){
+            entry.opcode = IORING_OP_READ_FIXED;
+            entry.addr = reinterpret_cast<std::uintptr_t>(slot.buffer);
+            entry.len = static_cast<std::uint32_t>(Constants::RecordReaderBufferSize);
+            entry.buf_index = static_cast<std::uint16_t>(slotIndex);
+        }else{
+            entry.opcode = IORING_OP_READV;
+            entry.addr = reinterpret_cast<std::uintptr_t>(&ring_->bufferVectors[slotIndex]);
+            entry.len = 1;
+        }
+        ring_->submissionArray[entryIndex] = entryIndex;
+
+        submissionTail += 1;
+        preparedCount += 1;
+    }
+    if(preparedCount == 0) return;
+
+    std::atomic_ref<unsigned>{*ring_->submissionTail}.store(submissionTail, std::memory_order_release);
+
+    // A slot only becomes pending once the kernel has taken its read, so awaitSlot never waits for
+    // one that was not submitted. The kernel takes entries in order and may take fewer than offered.
+    unsigned submittedCount{0};
+    int busyRetryCount{0};
+    while(submittedCount < preparedCount){
+        const int enteredCount{ring_->enter(preparedCount - submittedCount, 0)};
+        const int enterError{enteredCount < 0 ? errno : 0};
+
+        if(enteredCount > 0){
+            for(int enteredIndex{0}; enteredIndex < enteredCount; enteredIndex++){
+                slots_[(headSlot_ + pendingCount_) % slotCount].pending = true;
+                pendingCount_ += 1;
+                nextReadOffset_ += static_cast<long long int>(Constants::RecordReaderBufferSize);
+            }
+            submittedCount += static_cast<unsigned>(enteredCount);
+            busyRetryCount = 0;
+            continue;
+        }
+        if(enterError == EINTR) continue;
+
+        // short of kernel resources for now: carry on with the reads in flight, the rest are offered
+        // again by the next call, or with none in flight retry shortly
+        const bool isBusy{enteredCount == 0 || enterError == EAGAIN || enterError == EBUSY};
+        if(isBusy && pendingCount_ > 0) break;
+        if(isBusy && busyRetryCount < Constants::AsyncReadBusyRetryLimit){
+            busyRetryCount += 1;
+            std::this_thread::sleep_for(Constants::AsyncReadBusyRetryDelay);
+            continue;
+        }
+
+        withdrawSubmissions(preparedCount - submittedCount);
+        throw std::runtime_error{fmt::format("Failed to queue reads of '{}'. {}", filePath_, std::strerror(enterError != 0 ? enterError : EAGAIN))};
+    }
+
+    withdrawSubmissions(preparedCount - submittedCount);
+}
+
+void BlockReader::withdrawSubmissions(unsigned entryCount){
+    if(entryCount == 0) return;
+
+    // without a polling thread the kernel reads the submission ring only inside io_uring_enter, so
+    // entries it has not taken can be taken back by moving the tail
+    const unsigned submissionTail{*ring_->submissionTail};
+    std::atomic_ref<unsigned>{*ring_->submissionTail}.store(submissionTail - entryCount, std::memory_order_release);
+}
+
+void BlockReader::awaitSlot(const Slot &slot){
+    while(slot.pending){
+        unsigned completionHead{*ring_->completionHead}; // only ever written from here
+        const unsigned completionTail{std::atomic_ref<unsigned>{*ring_->completionTail}.load(std::memory_order_acquire)};
+
+        for(; completionHead != completionTail; completionHead++){
+            const io_uring_cqe &completion{ring_->completionEntries[completionHead & *ring_->completionMask]};
+            Slot &completedSlot{slots_[static_cast<std::size_t>(completion.user_data)]};
+            completedSlot.result = completion.res;
+            completedSlot.pending = false;
+        }
+        std::atomic_ref<unsigned>{*ring_->completionHead}.store(completionHead, std::memory_order_release);
+
+        if(!slot.pending) break;
+        if(ring_->enter(0, 1) < 0 && errno != EINTR){
+            throw std::runtime_error{fmt::format("Failed to wait for reads of '{}'. {}", filePath_, std::strerror(errno))};
+        }
+    }
+}
+
+void BlockReader::drainReads(){
+    for(const Slot &slot : slots_) awaitSlot(slot);
+    pendingCount_ = 0;
+}
+
+#else
+
+void BlockReader::submitReads(){}
+void BlockReader::withdrawSubmissions(unsigned){}
+void BlockReader::awaitSlot(const Slot &){}
+void BlockReader::drainReads(){}
+
+#endif
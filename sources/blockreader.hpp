@@ -0,0 +1,89 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+class ScanThrottle;
+
+// Reads a file front to back in large blocks, handed out strictly in file order.
+//
+// On Linux, several reads are kept in flight with io_uring into a pool of buffers that are
+// registered with the kernel once, so a fast device sees a queue depth above one. Where
+// io_uring is missing or refused (old kernels, seccomp profiles), and on other systems, each
+// block is read with a blocking call instead.
+//
+// Direct I/O (Linux only) bypasses the page cache. Its reads have to be aligned, so a seek
+// starts at the aligned offset below the requested one and skips the bytes in between.
+//
+// A short read ends the blocks known so far; the next call reads on from there, which is how a
+// file that is still growing gets followed.
+//
+// Every block handed out is charged to the throttle, if one is given, which may sleep there.
+class BlockReader{
+public:
+    struct Block{
+        const char *data;
+        std::size_t size;         // 0 at the end of the file
+        long long int fileOffset; // of data[0]
+    };
+
+    BlockReader(const std::string &filePath, bool directIo, ScanThrottle *throttle = nullptr);
+    ~BlockReader();
+
+    BlockReader(const BlockReader &) = delete;
+    BlockReader &operator=(const BlockReader &) = delete;
+
+    // The previously returned block's memory is reused from here on.
+    Block next();
+    void seek(long long int fileOffset);
+
+    bool usesIoUring() const{ return ring_ != nullptr; }
+    bool usesDirectIo() const{ return directIo_; }
+
+private:
+    struct Slot{
+        char *buffer;
+        long long int fileOffset{0};
+        int result{0};
+        bool pending{false};
+    };
+
+    Block readNext();
+    Block deliver(Slot &slot);  // turns a finished read into a block and decides where reading continues
+    void restartAt(long long int fileOffset);
+    int readBlocking(Slot &slot);
+
+    struct AlignedDelete{
+        void operator()(char *buffer) const;
+    };
+
+    struct IoUring;
+    void submitReads();
+    void withdrawSubmissions(unsigned entryCount); // the last entries put on the submission ring
+    void awaitSlot(const Slot &slot);
+    void drainReads();
+
+private:
+    std::string filePath_;
+    bool directIo_{false};
+    ScanThrottle *throttle_;
+
+#if defined(__linux__)
+    int fileDescriptor_{-1};
+#else
+    std::unique_ptr<std::FILE, int(*)(std::FILE *)> file_{nullptr, &std::fclose};
+#endif
+
+    std::unique_ptr<char[], AlignedDelete> bufferPool_;
+    std::vector<Slot> slots_; // used round robin, the pending ones follow headSlot_ in file order
+    std::size_t headSlot_{0};
+    std::size_t pendingCount_{0};
+
+    long long int nextReadOffset_{0}; // aligned file offset the next submitted read starts at
+    std::size_t skipBytes_{0};        // leading bytes of the next block that lie before the requested offset
+
+    std::unique_ptr<IoUring> ring_;
+};
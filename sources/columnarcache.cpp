@@ -0,0 +1,245 @@
+#include "columnarcache.hpp"
+
+#include <fmt/core.h>
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+
+#include "constants.hpp"
+
+namespace{
+
+    constexpr char CacheMagic[8]{'C', 'C', 'C', 'C', 'O', 'L', 'S', '1'};
+
+    template<typename Value>
+    void writeValue(std::ofstream &output, const Value value){
+        output.write(reinterpret_cast<const char *>(&value), sizeof(value));
+    }
+
+    template<typename Value>
+    Value readValue(std::ifstream &input){
+        Value value{};
+        input.read(reinterpret_cast<char *>(&value), sizeof(value));
+        if(!input) throw std::runtime_error{"Columnar cache is truncated."};
+        return value;
+    }
+
+} // namespace
+
+ColumnarCache::SourceStamp ColumnarCache::stampFile(const std::string &csvFilePath, const CsvDialect &dialect){
+    SourceStamp stamp;
+    stamp.fileSize = std::filesystem::file_size(csvFilePath);
+    stamp.modifiedTime = static_cast<std::int64_t>(std::filesystem::last_write_time(csvFilePath).time_since_epoch().count());
+    stamp.dialect = dialect;
+    return stamp;
+}
+
+void ColumnarCache::reset(const SourceStamp &stamp, const std::vector<int> &columnOffsets, const DictionaryOverflow overflow){
+    clear();
+
+    stamp_ = stamp;
+    building_ = true;
+    overflow_ = overflow;
+
+    for(const int columnOffset : columnOffsets){
+        if(columnOffset >= static_cast<int>(slotByOffset_.size())) slotByOffset_.resize(columnOffset + 1, -1);
+        if(slotByOffset_[columnOffset] >= 0) continue;
+
+        slotByOffset_[columnOffset] = static_cast<int>(columns_.size());
+        columns_.emplace_back().offset = columnOffset;
+    }
+}
+
+void ColumnarCache::clear(){
+    columns_.clear();
+    slotByOffset_.clear();
+    rowCount_ = 0;
+    building_ = false;
+}
+
+bool ColumnarCache::appendRow(const RowFieldList &fields){
+    if(!building_) return false;
+
+    for(Column &column : columns_){
+        if(column.dropped) continue;
+
+        // a missing trailing field behaves exactly like an empty one
+        const std::string_view cell{column.offset < static_cast<int>(fields.size()) ? fields[column.offset] : std::string_view{}};
+
+        auto dictionaryEntry{column.dictionaryIndex.find(cell)};
+        if(dictionaryEntry == column.dictionaryIndex.end()){
+            if(column.dictionary.size() >= Constants::ColumnarCacheMaxDictionarySize){
+                if(overflow_ == DictionaryOverflow::ABANDON_CACHE){
+                    clear();
+                    return false;
+                }
+
+                // the slot stays taken so the other columns keep theirs, only the data is released
+                slotByOffset_[column.offset] = -1;
+                column.dictionaryArena = StringArena{};
+                column.dictionaryIndex = {};
+                column.dictionary = {};
+                column.codes = CodeColumn{};
+                column.dropped = true;
+                continue;
+            }
+
+            const std::string_view storedCell{column.dictionaryArena.store(cell)};
+            dictionaryEntry = column.dictionaryIndex.emplace(storedCell, static_cast<Code>(column.dictionary.size())).first;
+            column.dictionary.push_back(storedCell);
+        }
+
+        column.codes.push(dictionaryEntry->second);
+    }
+
+    rowCount_ += 1;
+    return true;
+}
+
+void ColumnarCache::save(const std::string &filePath) const{
+    std::ofstream output{filePath, std::ios::binary | std::ios::trunc};
+    if(!output){
+        throw std::runtime_error{fmt::format("Could not open '{}' for writing.", filePath)};
+    }
+
+    output.write(CacheMagic, sizeof(CacheMagic));
+    writeValue(output, stamp_.fileSize);
+    writeValue(output, stamp_.modifiedTime);
+    writeValue(output, stamp_.dialect.delimiter);
+    writeValue(output, stamp_.dialect.quote);
+    writeValue(output, static_cast<std::uint8_t>(stamp_.dialect.trim));
+    writeValue(output, static_cast<std::int64_t>(rowCount_));
+    writeValue(output, static_cast<std::uint32_t>(std::count_if(
+        columns_.begin(), columns_.end(), [](const Column &column){ return !column.dropped; }
+    )));
+
+    for(const Column &column : columns_){
+        if(column.dropped) continue;
+
+        writeValue(output, static_cast<std::int32_t>(column.offset));
+        writeValue(output, static_cast<std::uint32_t>(column.dictionary.size()));
+        for(const std::string_view entry : column.dictionary){
+            writeValue(output, static_cast<std::uint32_t>(entry.size()));
+            output.write(entry.data(), static_cast<std::streamsize>(entry.size()));
+        }
+
+        writeValue(output, static_cast<std::uint8_t>(column.codes.width));
+        output.write(reinterpret_cast<const char *>(column.codes.bytes.data()), static_cast<std::streamsize>(column.codes.bytes.size()));
+    }
+
+    if(!output){
+        throw std::runtime_error{fmt::format("Failed to write columnar cache '{}'.", filePath)};
+    }
+}
+
+bool ColumnarCache::load(const std::string &filePath, const SourceStamp &expectedStamp){
+    try{
+        return loadUnchecked(filePath, expectedStamp);
+    }catch(const std::exception &){ // a truncated or foreign file is just a stale cache
+        clear();
+        return false;
+    }
+}
+
+bool ColumnarCache::loadUnchecked(const std::string &filePath, const SourceStamp &expectedStamp){
+    clear();
+
+    std::ifstream input{filePath, std::ios::binary};
+    if(!input) return false;
+
+    char magic[sizeof(CacheMagic)]{};
+    input.read(magic, sizeof(magic));
+    if(!input || !std::equal(std::begin(magic), std::end(magic), std::begin(CacheMagic))) return false;
+
+    SourceStamp stamp;
+    stamp.fileSize = readValue<std::uint64_t>(input);
+    stamp.modifiedTime = readValue<std::int64_t>(input);
+    stamp.dialect.delimiter = readValue<char>(input);
+    stamp.dialect.quote = readValue<char>(input);
+    stamp.dialect.trim = readValue<std::uint8_t>(input) != 0;
+    if(!(stamp == expectedStamp)) return false;
+
+    stamp_ = stamp;
+    rowCount_ = readValue<std::int64_t>(input);
+    if(rowCount_ < 0) throw std::runtime_error{"Columnar cache has a negative row count."};
+
+    const std::uint32_t columnCount{readValue<std::uint32_t>(input)};
+    for(std::uint32_t columnIndex{0}; columnIndex < columnCount; columnIndex++){
+        Column &column{columns_.emplace_back()};
+        column.offset = readValue<std::int32_t>(input);
+        if(column.offset < 0) throw std::runtime_error{"Columnar cache has a negative column offset."};
+
+        const std::uint32_t dictionarySize{readValue<std::uint32_t>(input)};
+        column.dictionary.reserve(dictionarySize);
+
+        std::string entry;
+        for(std::uint32_t entryIndex{0}; entryIndex < dictionarySize; entryIndex++){
+            entry.resize(readValue<std::uint32_t>(input));
+            input.read(entry.data(), static_cast<std::streamsize>(entry.size()));
+            column.dictionary.push_back(column.dictionaryArena.store(entry));
+        }
+
+        column.codes.width = readValue<std::uint8_t>(input);
+        if(column.codes.width != 1 && column.codes.width != 2 && column.codes.width != 4){
+            throw std::runtime_error{"Columnar cache has an invalid code width."};
+        }
+        column.codes.bytes.resize(static_cast<std::size_t>(rowCount_) * static_cast<std::size_t>(column.codes.width));
+        input.read(reinterpret_cast<char *>(column.codes.bytes.data()), static_cast<std::streamsize>(column.codes.bytes.size()));
+        if(!input) throw std::runtime_error{"Columnar cache is truncated."};
+
+        // codes index the dictionary unchecked from here on, so a damaged one must not get through
+        for(long long int row{0}; row < rowCount_; row++){
+            if(column.codes.get(row) >= dictionarySize) throw std::runtime_error{"Columnar cache has a code outside its dictionary."};
+        }
+
+        if(column.offset >= static_cast<int>(slotByOffset_.size())) slotByOffset_.resize(column.offset + 1, -1);
+        slotByOffset_[column.offset] = static_cast<int>(columnIndex);
+    }
+
+    return true;
+}
+
+int ColumnarCache::columnSlot(int columnOffset) const{
+    if(columnOffset < 0 || columnOffset >= static_cast<int>(slotByOffset_.size())) return -1;
+    return slotByOffset_[columnOffset];
+}
+
+ColumnarCache::Code ColumnarCache::code(int columnSlot, long long int row) const{
+    return columns_[columnSlot].codes.get(row);
+}
+
+void ColumnarCache::CodeColumn::push(Code code){
+    if(width < 2 && code > 0xFF) widen(2);
+    if(width < 4 && code > 0xFFFF) widen(4);
+
+    for(int byteIndex{0}; byteIndex < width; byteIndex++){
+        bytes.push_back(static_cast<std::uint8_t>(code >> (8 * byteIndex)));
+    }
+}
+
+ColumnarCache::Code ColumnarCache::CodeColumn::get(long long int row) const{
+    const std::uint8_t *encoded{&bytes[static_cast<std::size_t>(row) * static_cast<std::size_t>(width)]};
+    switch(width){
+        case 1: return encoded[0];
+        case 2: return static_cast<Code>(encoded[0] | (encoded[1] << 8));
+        default: return static_cast<Code>(encoded[0] | (encoded[1] << 8) | (encoded[2] << 16) | (static_cast<Code>(encoded[3]) << 24));
+    }
+}
+
+void ColumnarCache::CodeColumn::widen(int newWidth){
+    const std::size_t rowCount{bytes.size() / static_cast<std::size_t>(width)};
+
+    std::vector<std::uint8_t> widened;
+    widened.reserve(rowCount * static_cast<std::size_t>(newWidth));
+    for(std::size_t row{0}; row < rowCount; row++){
+        const Code code{get(static_cast<long long int>(row))};
+        for(int byteIndex{0}; byteIndex < newWidth; byteIndex++){
+            widened.push_back(static_cast<std::uint8_t>(code >> (8 * byteIndex)));
+        }
+    }
+
+    bytes = std::move(widened);
+    width = newWidth;
+}
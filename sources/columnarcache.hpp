@@ -0,0 +1,90 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "arena.hpp"
+#include "tokenizer.hpp"
+
+// Dictionary encoded copy of selected CSV columns. Each column keeps its distinct cell values
+// once and one small integer code per row, so re-evaluating the same file with different
+// invalid values only has to classify the dictionary and then walk the codes.
+class ColumnarCache{
+public:
+    using Code = std::uint32_t;
+
+    struct SourceStamp{ // identifies the exact CSV contents and dialect a cache was built from
+        std::uint64_t fileSize{0};
+        std::int64_t modifiedTime{0};
+        CsvDialect dialect;
+
+        bool operator==(const SourceStamp &other) const{
+            return fileSize == other.fileSize
+                && modifiedTime == other.modifiedTime
+                && dialect.delimiter == other.dialect.delimiter
+                && dialect.quote == other.dialect.quote
+                && dialect.trim == other.dialect.trim;
+        }
+    };
+
+    enum class DictionaryOverflow{ // what happens once a column has too many distinct values
+        ABANDON_CACHE, // the whole cache is cleared
+        DROP_COLUMN    // only that column stops being cached, the others stay usable
+    };
+
+    static SourceStamp stampFile(const std::string &csvFilePath, const CsvDialect &dialect);
+
+    void reset(
+        const SourceStamp &stamp,
+        const std::vector<int> &columnOffsets,
+        DictionaryOverflow overflow = DictionaryOverflow::ABANDON_CACHE
+    );
+    void clear();
+
+    // interns the cells of one row; returns false once a dictionary outgrows the cache limit
+    bool appendRow(const RowFieldList &fields);
+
+    void save(const std::string &filePath) const;
+    bool load(const std::string &filePath, const SourceStamp &expectedStamp); // false when missing or stale
+
+    bool isBuilding() const{ return building_; }
+    const SourceStamp &stamp() const{ return stamp_; }
+    long long int rowCount() const{ return rowCount_; }
+
+    int columnSlot(int columnOffset) const; // -1 when the column is not cached
+    const std::vector<std::string_view> &dictionary(int columnSlot) const{ return columns_[columnSlot].dictionary; }
+    Code code(int columnSlot, long long int row) const;
+
+private:
+    bool loadUnchecked(const std::string &filePath, const SourceStamp &expectedStamp);
+
+private:
+    struct CodeColumn{ // codes are stored 1, 2 or 4 bytes wide depending on the dictionary size
+        int width{1};
+        std::vector<std::uint8_t> bytes;
+
+        void push(Code code);
+        Code get(long long int row) const;
+        void widen(int newWidth);
+    };
+
+    struct Column{
+        int offset{0};
+        StringArena dictionaryArena;
+        std::unordered_map<std::string_view, Code> dictionaryIndex; // only populated while building
+        std::vector<std::string_view> dictionary;
+        CodeColumn codes;
+        bool dropped{false}; // outgrew the dictionary limit under DictionaryOverflow::DROP_COLUMN
+    };
+
+private:
+    SourceStamp stamp_;
+    std::vector<Column> columns_;
+    std::vector<int> slotByOffset_;
+    long long int rowCount_{0};
+    bool building_{false};
+    DictionaryOverflow overflow_{DictionaryOverflow::ABANDON_CACHE};
+};
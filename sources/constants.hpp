@@ -1,6 +1,8 @@
 #pragma once
 
 #include <chrono>
+#include <cstddef>
+#include <cstdint>
 
 namespace Constants{
 
@@ -10,7 +12,63 @@ namespace Constants{
     constexpr const char *DefaultBaseJsonName{"csv_completeness_checker"};
 
     constexpr std::chrono::seconds ProgressUpdateInterval{1};
-    constexpr std::chrono::milliseconds ProgressMinimumPollInterval{50};
-    constexpr std::chrono::milliseconds ProgressDefaultPollInterval{250};
+
+    // files up to this size finish well within one progress interval, so they are scanned on the calling thread
+    constexpr std::uintmax_t InlineProcessingMaxFileSize{4 << 20};
+
+    constexpr std::size_t ArenaBlockSize{1 << 20};
+
+    constexpr std::size_t RecordReaderBufferSize{1 << 20};
+    constexpr std::size_t AsyncReadQueueDepth{8}; // record reader blocks kept in flight where io_uring is available
+    constexpr int AsyncReadBusyRetryLimit{100};   // submissions refused for lack of kernel resources while no read is in flight
+    constexpr std::chrono::milliseconds AsyncReadBusyRetryDelay{1};
+
+    // a throttled scan may run ahead of its read rate and CPU budget by this much refill
+    constexpr std::chrono::milliseconds ThrottleBurstDuration{250};
+
+    constexpr std::size_t ColumnarCacheMaxDictionarySize{1 << 20}; // distinct values per column before caching is abandoned
+
+    // interactive sessions pre-scan files up to this size, every column of them is held in memory
+    constexpr std::uintmax_t PrescanMaxFileSize{1ULL << 30};
+    constexpr long long int PrescanBatchRowCount{4096}; // rows read between chances for a preview to look at the cache
+    constexpr std::size_t PreviewFrequentValueCount{8};
+
+    constexpr std::size_t PatternMaxDfaStates{4096}; // per column, 1 KiB of transitions each
+    constexpr int PatternMaxRepetition{1000}; // largest bound of a {m,n} quantifier, each copies its expression
+
+    constexpr std::size_t ClauseReorderInterval{4096}; // rows between reorderings of a combination's operands
+
+    constexpr int HyperLogLogPrecision{14}; // 16 KiB of registers per sketch, about 0.8% standard error
+    constexpr char DistinctKeySeparator{'\x1f'}; // ASCII unit separator between the fields of a composite key
+
+    // per profiled column: 256 KiB of Count-Min cells, overestimating a count by at most 1/3000 of
+    // the rows with 98% certainty, in front of 256 values tracked by name
+    constexpr std::size_t ValueProfileSketchWidth{1 << 13};
+    constexpr std::size_t ValueProfileSketchDepth{4};
+    constexpr std::size_t ValueProfileCapacity{256};
+    constexpr std::size_t ValueProfileReportCount{10};
+    constexpr long long int PlaceholderMinimumCount{2}; // a suggested placeholder has been seen this often for certain
+
+    constexpr std::size_t ExplainSampleBytes{1 << 20}; // of data rows read to estimate the cost of a scan
+    constexpr int ExplainTimingRounds{3};
+
+    constexpr int QualityGateFailureExitCode{2}; // 1 is taken by errors
+
+    constexpr long long int QualityGateCheckInterval{4096}; // rows between early exit decisions
+    constexpr double SequentialGateErrorRate{0.001};         // chance that a sequential decision is wrong over the whole scan
+
+    // a drop below the baseline is flagged once it is unlikely to be noise (two-sided 0.1% level)
+    // and at least a tenth of a percentage point, which millions of rows would otherwise undercut
+    constexpr double BaselineRegressionZScore{3.29};
+    constexpr double BaselineMinimumRegression{0.001};
+
+    constexpr std::chrono::seconds FollowPublishInterval{5};
+    constexpr std::chrono::milliseconds FollowPollInterval{250}; // without inotify
+
+    // rows a scan may take to grow its reused buffers before further allocations count as data row ones
+    constexpr long long int AllocationWarmUpRowCount{1024};
+
+    constexpr std::size_t CopyBufferSize{4 << 20};
+    constexpr std::size_t CopyBufferAlignment{4096};
 
 } // namespace Constants
\ No newline at end of file
@@ -0,0 +1,83 @@
+#include "filewatcher.hpp"
+
+#include <algorithm>
+#include <array>
+#include <filesystem>
+#include <thread>
+
+#if defined(__linux__)
+    #include <poll.h>
+    #include <sys/inotify.h>
+    #include <unistd.h>
+#endif
+
+#if defined(__unix__) || defined(__APPLE__)
+    #include <sys/stat.h>
+#endif
+
+#include "constants.hpp"
+
+FileWatcher::FileWatcher(const std::string &filePath) : filePath_{filePath}, identity_{identify()}{
+#if defined(__linux__)
+    // watching the directory instead of the file survives the file being renamed or replaced
+    const std::filesystem::path parentPath{std::filesystem::path{filePath_}.parent_path()};
+    const std::string directoryPath{parentPath.empty() ? std::string{"."} : parentPath.string()};
+
+    notifyDescriptor_ = ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if(notifyDescriptor_ >= 0){
+        const int watchDescriptor{::inotify_add_watch(
+            notifyDescriptor_,
+            directoryPath.c_str(),
+            IN_MODIFY | IN_CLOSE_WRITE | IN_CREATE | IN_MOVED_TO | IN_MOVED_FROM | IN_DELETE
+        )};
+        if(watchDescriptor < 0){
+            ::close(notifyDescriptor_);
+            notifyDescriptor_ = -1; // falls back to sleeping
+        }
+    }
+#endif
+}
+
+FileWatcher::~FileWatcher(){
+#if defined(__linux__)
+    if(notifyDescriptor_ >= 0) ::close(notifyDescriptor_);
+#endif
+}
+
+void FileWatcher::waitForChange(std::chrono::milliseconds timeout){
+    timeout = std::max(timeout, std::chrono::milliseconds{0});
+
+#if defined(__linux__)
+    if(notifyDescriptor_ >= 0){
+        pollfd notifyPoll{notifyDescriptor_, POLLIN, 0};
+        if(::poll(&notifyPoll, 1, static_cast<int>(timeout.count())) > 0){
+            // any event in the directory only means "look again", so the events themselves are dropped
+            std::array<char, 4096> eventBuffer;
+            while(::read(notifyDescriptor_, eventBuffer.data(), eventBuffer.size()) > 0){}
+        }
+        return;
+    }
+#endif
+
+    std::this_thread::sleep_for(std::min(timeout, std::chrono::duration_cast<std::chrono::milliseconds>(Constants::FollowPollInterval)));
+}
+
+bool FileWatcher::wasReplaced() const{
+    return identify() != identity_;
+}
+
+void FileWatcher::rearm(){
+    identity_ = identify();
+}
+
+FileWatcher::FileIdentity FileWatcher::identify() const{
+#if defined(__unix__) || defined(__APPLE__)
+    struct stat fileStatus{};
+    if(::stat(filePath_.c_str(), &fileStatus) != 0) return {};
+    return {static_cast<std::uint64_t>(fileStatus.st_dev), static_cast<std::uint64_t>(fileStatus.st_ino), true};
+#else
+    // without inode numbers only truncation can be detected, through the file size
+    std::error_code existsError;
+    return {0, 0, std::filesystem::exists(filePath_, existsError)};
+#endif
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+// Waits for a file that is still being written to change. On Linux the file's directory is
+// watched through inotify, which wakes the caller on appends as well as on the renames and
+// creations of a log rotation. Elsewhere it falls back to sleeping for a short interval.
+class FileWatcher{
+public:
+    explicit FileWatcher(const std::string &filePath);
+    ~FileWatcher();
+
+    FileWatcher(const FileWatcher &) = delete;
+    FileWatcher &operator=(const FileWatcher &) = delete;
+
+    // returns early when the file may have changed, or when a signal interrupts the wait
+    void waitForChange(std::chrono::milliseconds timeout);
+
+    // whether the path now names another file than at construction or the last rearm()
+    bool wasReplaced() const;
+    void rearm();
+
+private:
+    struct FileIdentity{
+        std::uint64_t device{0};
+        std::uint64_t inode{0};
+        bool exists{false};
+
+        bool operator==(const FileIdentity &) const = default;
+    };
+    FileIdentity identify() const;
+
+private:
+    std::string filePath_;
+    FileIdentity identity_;
+    int notifyDescriptor_{-1};
+};
@@ -0,0 +1,81 @@
+#include "hyperloglog.hpp"
+
+#include <fmt/core.h>
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <stdexcept>
+
+HyperLogLog::HyperLogLog(int precision) : precision_{precision}{
+    if(precision_ < 4 || precision_ > 18){
+        throw std::invalid_argument{fmt::format("HyperLogLog precision {} is outside 4..18.", precision_)};
+    }
+    registers_.assign(std::size_t{1} << precision_, 0);
+}
+
+HyperLogLog HyperLogLog::fromRegisters(std::vector<std::uint8_t> registers){
+    if(!std::has_single_bit(registers.size())){
+        throw std::invalid_argument{fmt::format("HyperLogLog register count {} is not a power of two.", registers.size())};
+    }
+
+    HyperLogLog sketch{std::countr_zero(registers.size())};
+    sketch.registers_ = std::move(registers);
+    return sketch;
+}
+
+std::uint64_t HyperLogLog::hash(std::string_view key){
+    // FNV-1a spreads the bytes, the murmur3 finalizer then makes every output bit depend on
+    // all of them, which the leading zero count relies on
+    std::uint64_t keyHash{14695981039346656037ull};
+    for(const char character : key){
+        keyHash ^= static_cast<unsigned char>(character);
+        keyHash *= 1099511628211ull;
+    }
+
+    keyHash ^= keyHash >> 33;
+    keyHash *= 0xff51afd7ed558ccdull;
+    keyHash ^= keyHash >> 33;
+    keyHash *= 0xc4ceb9fe1a85ec53ull;
+    keyHash ^= keyHash >> 33;
+    return keyHash;
+}
+
+std::uint8_t HyperLogLog::leadingZeroRank(std::uint64_t bits){
+    return static_cast<std::uint8_t>(std::countl_zero(bits) + 1);
+}
+
+void HyperLogLog::merge(const HyperLogLog &other){
+    if(other.precision_ != precision_){
+        throw std::invalid_argument{fmt::format(
+            "Cannot merge HyperLogLog sketches of precision {} and {}.",
+            precision_,
+            other.precision_
+        )};
+    }
+
+    std::transform(
+        registers_.begin(), registers_.end(), other.registers_.begin(), registers_.begin(),
+        [](const std::uint8_t left, const std::uint8_t right){ return std::max(left, right); }
+    );
+}
+
+double HyperLogLog::estimate() const{
+    const double registerCount{static_cast<double>(registers_.size())};
+
+    double inverseSum{0.0};
+    std::size_t emptyRegisters{0};
+    for(const std::uint8_t rank : registers_){
+        inverseSum += std::ldexp(1.0, -rank);
+        if(rank == 0) emptyRegisters += 1;
+    }
+
+    const double alpha{0.7213 / (1.0 + 1.079 / registerCount)};
+    const double rawEstimate{alpha * registerCount * registerCount / inverseSum};
+
+    // the raw estimate is biased while most registers are still empty, count the empty ones instead
+    if(rawEstimate <= 2.5 * registerCount && emptyRegisters > 0){
+        return registerCount * std::log(registerCount / static_cast<double>(emptyRegisters));
+    }
+    return rawEstimate;
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+#include "constants.hpp"
+
+// Fixed memory estimator of the number of distinct keys seen (Flajolet et al., with linear
+// counting for small cardinalities). Each of the 2^precision one byte registers keeps the
+// longest run of leading zero bits among the hashes routed to it, so the sketch never grows
+// with the input. Two sketches of the same precision merge by taking the register maxima,
+// which lets partial scans be combined into the sketch of their union.
+class HyperLogLog{
+public:
+    explicit HyperLogLog(int precision = Constants::HyperLogLogPrecision);
+
+    // restores a sketch from the registers of another one, e.g. written into a partial result
+    static HyperLogLog fromRegisters(std::vector<std::uint8_t> registers);
+
+    // stable across platforms and runs, so sketches written by different processes agree
+    static std::uint64_t hash(std::string_view key);
+
+    void add(std::uint64_t keyHash){
+        const std::uint32_t registerIndex{static_cast<std::uint32_t>(keyHash >> (64 - precision_))};
+        const std::uint64_t remainingBits{keyHash << precision_};
+        const std::uint8_t rank{remainingBits == 0 ? static_cast<std::uint8_t>(64 - precision_ + 1) : leadingZeroRank(remainingBits)};
+        if(rank > registers_[registerIndex]) registers_[registerIndex] = rank;
+    }
+    void add(std::string_view key){ add(hash(key)); }
+
+    void merge(const HyperLogLog &other);
+
+    double estimate() const;
+
+    int precision() const{ return precision_; }
+    const std::vector<std::uint8_t> &registers() const{ return registers_; }
+
+private:
+    static std::uint8_t leadingZeroRank(std::uint64_t bits);
+
+private:
+    int precision_;
+    std::vector<std::uint8_t> registers_;
+};
@@ -5,8 +5,6 @@
 #include <fmt/core.h>
 #include <fmt/ranges.h>
 
-#include <csv.h>
-
 void NaNalyzer::parseCsv(){
 	fmt::print(
 		"Enter the path to the source CSV file or an initialization JSON file "
@@ -39,20 +37,7 @@ void NaNalyzer::parseCsv(){
 	}else{
 		csvFilePath_ = std::move(userInput);
 
-		io::LineReader csvLineReader{csvFilePath_};
-		try{
-			char *headerLine{csvLineReader.next_line()};
-			if(!headerLine){
-				throw std::runtime_error{"No header line found in CSV file."};
-			}
-			headers_ = splitString(std::string{headerLine}, ',');
-		}catch(const std::exception &exception){
-			throw std::runtime_error{fmt::format(
-				"Could not open or read file '{}'. {}",
-				csvFilePath_,
-				exception.what()
-			)};
-		}
+		headers_ = readCsvHeader(csvFilePath_);
 	}
 
 	clearInputBuffer();
@@ -63,6 +48,9 @@ void NaNalyzer::parseCsv(){
 
 	fmt::println("Source CSV file: {}", csvFilePath_);
 
+	// prompts still to come leave time to read the file, and their answers can then be previewed
+	if(columns_.empty() || columnCombinationsToCheck_.empty()) startPrescan();
+
 	fmt::println("\n--- Discovered Fields ---");
 	for(std::size_t headerIndex{0}; headerIndex < headers_.size(); headerIndex++){
 		fmt::println("[{}] {}", headerIndex + 1, headers_[headerIndex]);
@@ -129,6 +117,28 @@ void NaNalyzer::defineInvalidData(){
 		return value.substr(firstNonWhitespace, lastNonWhitespace - firstNonWhitespace + 1);
 	}};
 
+	const auto printValuePreview{[this](const Column &column, const bool showFrequentValues){
+		const std::optional<PrescanPreview> preview{previewColumnValues(column)};
+		if(!preview.has_value() || preview->rowCount == 0) return;
+
+		fmt::println(
+			"'{}' is valid in {} / {} rows ({:.2f}%){}.",
+			column.name,
+			preview->validCount,
+			preview->rowCount,
+			(static_cast<float>(preview->validCount) / static_cast<float>(preview->rowCount)) * 100.0f,
+			preview->complete ? "" : " scanned so far"
+		);
+
+		if(showFrequentValues){
+			std::vector<std::string> frequentValuesDisplay;
+			for(const auto &[value, count] : preview->frequentValues){
+				frequentValuesDisplay.push_back(fmt::format("\"{}\" ({})", value, count));
+			}
+			fmt::println("Most frequent values: {}", fmt::join(frequentValuesDisplay, ", "));
+		}
+	}};
+
 	while(columns_.empty()){
 		fmt::print("Field numbers: ");
 		if(!std::cin.good()) std::cin.clear();
@@ -275,6 +285,8 @@ void NaNalyzer::defineInvalidData(){
 		Column &selectedColumn{columns_.at(selectedFieldNumber)};
 		bool replaceExisting{false};
 
+		printValuePreview(selectedColumn, true);
+
 		if(selectedColumn.invalidValues.empty()){
 			fmt::println("'{}' doesn't have any invalid values yet. New entries will be added to the list.", selectedColumn.name);
 		}else{
@@ -325,6 +337,7 @@ void NaNalyzer::defineInvalidData(){
 			if(replaceExisting){
 				selectedColumn.invalidValues.clear();
 				fmt::println("Cleared invalid values for '{}'.", selectedColumn.name);
+				printValuePreview(selectedColumn, false);
 			}else{
 				fmt::println("No new values provided for '{}'. Keeping existing list.", selectedColumn.name);
 			}
@@ -353,6 +366,7 @@ void NaNalyzer::defineInvalidData(){
 					: "Updated invalid values for '{}'."
 			};
 			fmt::println(fmt::runtime(message), selectedColumn.name);
+			printValuePreview(selectedColumn, false);
 		}else{
 			if(replaceExisting){
 				fmt::println("No non-empty entries were provided. '{}' now has an empty invalid value list.", selectedColumn.name);
@@ -408,6 +422,7 @@ void NaNalyzer::defineColumnCombinations(){
 	fmt::println("Enter field combinations (\":\" = together, \"/\" = alternatives, \",\" = separate rules)");
 	fmt::println("Example: 1:2:3/4 means fields 1 & 2 and either 3 or 4.");
 	fmt::println("Multiple combos: 1, 2:3, 1:2:3/4");
+	fmt::println("Rules: ! = not, & = and, | = or, atleast(k, ...), e.g. 1 & (2 | !3) & atleast(2, 4, 5, 6)");
 	if(!defaultCombinationDisplay.empty()){
 		fmt::println("Leave empty to use all fields [{}].", defaultCombinationDisplay);
 	}
@@ -434,33 +449,43 @@ void NaNalyzer::defineColumnCombinations(){
 			throw std::runtime_error{"No fields were selected. Cannot define combinations."};
 		}
 
-		ColumnCombination defaultCombination;
-		defaultCombination.reserve(sortedColumnIdentifiers.size());
+		std::vector<ColumnDisjunction> defaultClauses;
+		defaultClauses.reserve(sortedColumnIdentifiers.size());
 
 		for(const int columnIdentifier : sortedColumnIdentifiers){
 			const Column &columnDefinition{columns_.at(columnIdentifier)};
 			ColumnDisjunction clause;
 			clause.push_back(columnDefinition.index);
-			defaultCombination.push_back(std::move(clause));
+			defaultClauses.push_back(std::move(clause));
 		}
 
-		columnCombinationsToCheck_.push_back(std::move(defaultCombination));
+		columnCombinationsToCheck_.push_back(RuleExpression::fromClauses(defaultClauses));
 		fmt::println(
 			"Using default combination: [{}]",
 			fmt::join(sortedColumnIdentifiers, ":")
 		);
+		printCompletenessPreview();
 		return;
 	}
 
-	DelimitedStringList combinationStrings{splitString(combinationInput, ',')};
+	DelimitedStringList combinationStrings{splitCombinationList(combinationInput)};
 
 	for(const std::string &combinationString : combinationStrings){
+		if(RuleExpression::isExpressionSyntax(combinationString)){
+			try{
+				columnCombinationsToCheck_.push_back(parseCombinationString(combinationString));
+			}catch(const std::exception &exception){
+				fmt::println(stderr, "{} Skipping this combination.", exception.what());
+			}
+			continue;
+		}
+
 		DelimitedStringList clauseStrings{splitString(combinationString, ':')};
 
 		if(clauseStrings.empty()) continue;
 
-		ColumnCombination currentCombination;
-		currentCombination.reserve(clauseStrings.size());
+		std::vector<ColumnDisjunction> currentClauses;
+		currentClauses.reserve(clauseStrings.size());
 		bool isCombinationValid{true};
 
 		for(const std::string &clauseString : clauseStrings){
@@ -512,15 +537,43 @@ void NaNalyzer::defineColumnCombinations(){
 
 			std::sort(disjunction.begin(), disjunction.end());
 			disjunction.erase(std::unique(disjunction.begin(), disjunction.end()), disjunction.end());
-			currentCombination.push_back(std::move(disjunction));
+			currentClauses.push_back(std::move(disjunction));
 		}
 
-		if(isCombinationValid && !currentCombination.empty()){
-			columnCombinationsToCheck_.push_back(std::move(currentCombination));
+		if(isCombinationValid && !currentClauses.empty()){
+			columnCombinationsToCheck_.push_back(RuleExpression::fromClauses(currentClauses));
 		}
 	}
 
 	if(columnCombinationsToCheck_.empty()){
 		throw std::runtime_error{"No valid combinations were provided."};
 	}
+
+	printCompletenessPreview();
+}
+
+void NaNalyzer::printCompletenessPreview() const{
+	bool hasPrintedHeading{false};
+
+	for(const ColumnCombination &combination : columnCombinationsToCheck_){
+		const std::optional<PrescanPreview> preview{previewCompleteness(combination)};
+		if(!preview.has_value() || preview->rowCount == 0) continue;
+
+		if(!hasPrintedHeading){
+			fmt::println(
+				"\n--- Completeness Preview ({} rows{}) ---",
+				preview->rowCount,
+				preview->complete ? "" : " scanned so far"
+			);
+			hasPrintedHeading = true;
+		}
+
+		fmt::println(
+			"[{}] : {} / {} ({:.2f}%)",
+			formatCombinationForDisplay(combination),
+			preview->validCount,
+			preview->rowCount,
+			(static_cast<float>(preview->validCount) / static_cast<float>(preview->rowCount)) * 100.0f
+		);
+	}
 }
\ No newline at end of file
@@ -16,11 +16,41 @@ int main(int argumentCount, char *arguments[]){
         ("o,output", "Path to save output JSON results", cxxopts::value<std::string>())
         ("f,fields", "Comma-separated field numbers to analyze (e.g., 1,2,3,5)", cxxopts::value<std::string>())
         ("i,invalid-values", "Invalid values mapping (format: field:value1,value2:field:value3...)", cxxopts::value<std::string>())
-        ("b,combinations", "Column combinations to check (format: 1:2,1:3/4)", cxxopts::value<std::string>())
-        ("format", "Output format: text, json, csv, or keyvalue (force quiet mode) (default: text)", cxxopts::value<std::string>()->default_value("text"))
+        ("p,invalid-pattern", "Regular expression marking a field's values invalid (format: field=pattern, repeatable)", cxxopts::value<std::vector<std::string>>())
+        ("t,type-rule", "Type a field's values must have (format: field=integer|float|date|timestamp[:min..max] or field=enum:a|b, repeatable)", cxxopts::value<std::vector<std::string>>())
+        ("where", "Only count rows matching this filter (format: field==value, field!=value, field in {a,b} or field not in {a,b}; field number or header name; repeatable, all must hold)", cxxopts::value<std::vector<std::string>>())
+        ("b,combinations", "Column combinations to check (format: 1:2,1:3/4, or rules such as 1 & (2 | !3) & atleast(2, 4,5,6))", cxxopts::value<std::string>())
+        ("g,group-by", "Report completeness separately for each distinct value of this field (number or header name)", cxxopts::value<std::string>())
+        ("distinct-on", "Also report completeness over distinct entities keyed by these fields (numbers or header names, e.g., 1,3): an entity counts as valid when any of its rows satisfies the combination", cxxopts::value<std::string>())
+        ("distinct-mode", "Distinct entity counting: 'exact' (default) or 'hll' (fixed memory HyperLogLog estimate)", cxxopts::value<std::string>())
+        ("w,window", "Stream completeness for every N rows, or every N megabytes with an MB suffix (e.g., 100000 or 64MB)", cxxopts::value<std::string>())
+        ("follow", "Keep reading rows appended to the CSV, surviving rotation and truncation, and print the running results every N seconds (default: 5) until interrupted", cxxopts::value<std::string>()->implicit_value("5"))
+        ("failed-rows", "Path to save the row numbers and byte ranges failing each combination (JSON)", cxxopts::value<std::string>())
+        ("split", "Copy rows satisfying this combination to <csv>_valid.csv and the rest to <csv>_rejected.csv (e.g., 1:2/3)", cxxopts::value<std::string>())
+        ("d,delimiter", "Field delimiter: ',', ';', '|' or 'tab' (default: ,)", cxxopts::value<std::string>())
+        ("quote", "Quote character: '\"', \"'\" or 'none' (default: none)", cxxopts::value<std::string>())
+        ("no-trim", "Keep whitespace around unquoted fields", cxxopts::value<bool>()->default_value("false"))
+        ("cache", "Columnar cache file: reused when it matches the CSV, otherwise rebuilt during the scan", cxxopts::value<std::string>())
+        ("fail-under", "Exit with code 2 when a combination's completeness is below a ratio (format: combination=ratio, e.g., 1:2=0.98 or 1:2=98%, repeatable)", cxxopts::value<std::vector<std::string>>())
+        ("early-exit", "Stop scanning once every --fail-under gate is decided: 'exact' (default) or 'sequential'", cxxopts::value<std::string>()->implicit_value("exact"))
+        ("metrics-textfile", "Prometheus node-exporter textfile (*.prom) rewritten atomically with progress during the scan and the final metrics after it", cxxopts::value<std::string>())
+        ("baseline", "Earlier CSV to compare against: scanned alongside with the same configuration, reporting per combination deltas and significant regressions (its result is saved as <baseline>.completeness.json and reused while the file is unchanged)", cxxopts::value<std::string>())
+        ("profile-values", "Also find each selected field's most frequent values in fixed memory, and save a configuration with likely placeholders (NULL, ?, 0000-00-00, ...) added to its invalid values (default file: <csv>.profile.json)", cxxopts::value<std::string>()->implicit_value(""))
+        ("byte-range", "Scan only the rows starting in this byte range (format: START:END, END may be left out) and print a partial result JSON for the merge subcommand", cxxopts::value<std::string>())
+        ("direct-io", "Read the CSV with direct I/O, bypassing the page cache (Linux only; file systems that refuse it are read normally)", cxxopts::value<bool>()->default_value("false"))
+        ("max-read-rate", "Read the CSV at most this many megabytes per second (e.g., 50), leaving disk bandwidth to other services", cxxopts::value<std::string>())
+        ("cpu-budget", "Sleep as needed to use at most this share of one core on average (e.g., 0.25 or 25%)", cxxopts::value<std::string>())
+        ("nice", "Scheduling nice value of the scan, from -20 to 19 (lowest priority) (Linux only)", cxxopts::value<int>())
+        ("io-priority", "I/O scheduling class of the scan: idle, best-effort or best-effort:N with N from 0 to 7 (lowest) (Linux only)", cxxopts::value<std::string>())
+        ("explain", "Print the evaluation plan (normalized combinations, columns read, each field's checks) and a runtime estimate from a sample of the first megabyte, without processing the file", cxxopts::value<bool>()->default_value("false"))
+        ("stats", "Print scan statistics to stderr after the results: throughput, peak resident memory and, in builds configured with -DALLOCATION_ACCOUNTING=ON, heap allocations per phase", cxxopts::value<bool>()->default_value("false"))
+        ("format", "Output format: text, json, csv, keyvalue, or openmetrics (force quiet mode) (default: text)", cxxopts::value<std::string>()->default_value("text"))
         ("q,silent", "Minimal output (only results)", cxxopts::value<bool>()->default_value("false"))
         ("h,help", "Print help")
+        ("subcommand", "merge PARTIAL.json... combines partial results written with --byte-range", cxxopts::value<std::vector<std::string>>())
     ;
+    options.parse_positional({"subcommand"});
+    options.positional_help("[merge PARTIAL.json...]");
 
     try{
         auto parseResult{options.parse(argumentCount, arguments)};
@@ -31,6 +61,33 @@ int main(int argumentCount, char *arguments[]){
         }
 
         CLIConfig config{};
+
+        if(parseResult.count("subcommand")){
+            const auto &subcommandArguments{parseResult["subcommand"].as<std::vector<std::string>>()};
+            if(subcommandArguments.front() != "merge"){
+                throw std::invalid_argument{fmt::format("Unknown subcommand '{}'. Did you mean merge?", subcommandArguments.front())};
+            }
+            if(subcommandArguments.size() < 2){
+                throw std::invalid_argument{"merge needs at least one partial result file."};
+            }
+            config.mergeInputs.assign(subcommandArguments.begin() + 1, subcommandArguments.end());
+
+            // the partials fix everything their counts depend on, only the reporting can still be chosen
+            for(const char *optionName : {
+                "csv", "config", "output", "fields", "invalid-values", "invalid-pattern", "type-rule", "where", "combinations",
+                "group-by", "distinct-on", "distinct-mode", "window", "follow", "failed-rows", "split",
+                "delimiter", "quote", "no-trim", "cache", "early-exit", "byte-range", "baseline", "direct-io"
+            }){
+                if(parseResult.count(optionName)){
+                    throw std::invalid_argument{fmt::format("--{} cannot be used with merge, the partial results fix the configuration.", optionName)};
+                }
+            }
+            for(const char *optionName : {"max-read-rate", "cpu-budget", "nice", "io-priority", "explain"}){
+                if(parseResult.count(optionName)){
+                    throw std::invalid_argument{fmt::format("--{} cannot be used with merge, which only reads the small partial results.", optionName)};
+                }
+            }
+        }
         
         if(parseResult.count("csv")){
             config.csvFilePath = parseResult["csv"].as<std::string>();
@@ -47,9 +104,91 @@ int main(int argumentCount, char *arguments[]){
         if(parseResult.count("invalid-values")){
             config.invalidValuesInput = parseResult["invalid-values"].as<std::string>();
         }
+        for(const auto &argument : parseResult.arguments()){
+            // read each occurrence raw, patterns, rules and filters may contain the vector delimiter ','
+            if(argument.key() == "invalid-pattern"){
+                config.invalidPatternInputs.push_back(argument.value());
+            }else if(argument.key() == "type-rule"){
+                config.typeRuleInputs.push_back(argument.value());
+            }else if(argument.key() == "fail-under"){
+                config.failUnderInputs.push_back(argument.value());
+            }else if(argument.key() == "where"){
+                config.whereInputs.push_back(argument.value());
+            }
+        }
         if(parseResult.count("combinations")){
             config.combinationsInput = parseResult["combinations"].as<std::string>();
         }
+        if(parseResult.count("group-by")){
+            config.groupByInput = parseResult["group-by"].as<std::string>();
+        }
+        if(parseResult.count("distinct-on")){
+            config.distinctOnInput = parseResult["distinct-on"].as<std::string>();
+        }
+        if(parseResult.count("distinct-mode")){
+            config.distinctModeInput = parseResult["distinct-mode"].as<std::string>();
+        }
+        if(parseResult.count("window")){
+            config.windowInput = parseResult["window"].as<std::string>();
+        }
+        if(parseResult.count("follow")){
+            config.followInput = parseResult["follow"].as<std::string>();
+        }
+        if(parseResult.count("failed-rows")){
+            config.failedRowsFilePath = parseResult["failed-rows"].as<std::string>();
+        }
+        if(parseResult.count("split")){
+            config.splitCombinationInput = parseResult["split"].as<std::string>();
+        }
+        if(parseResult.count("delimiter")){
+            config.delimiterInput = parseResult["delimiter"].as<std::string>();
+        }
+        if(parseResult.count("quote")){
+            config.quoteInput = parseResult["quote"].as<std::string>();
+        }
+        if(parseResult.count("no-trim")){
+            config.noTrim = parseResult["no-trim"].as<bool>();
+        }
+        if(parseResult.count("cache")){
+            config.cacheFilePath = parseResult["cache"].as<std::string>();
+        }
+        if(parseResult.count("early-exit")){
+            config.earlyExitInput = parseResult["early-exit"].as<std::string>();
+        }
+        if(parseResult.count("metrics-textfile")){
+            config.metricsTextfilePath = parseResult["metrics-textfile"].as<std::string>();
+        }
+        if(parseResult.count("baseline")){
+            config.baselineFilePath = parseResult["baseline"].as<std::string>();
+        }
+        if(parseResult.count("profile-values")){
+            config.profileValuesInput = parseResult["profile-values"].as<std::string>();
+        }
+        if(parseResult.count("byte-range")){
+            config.byteRangeInput = parseResult["byte-range"].as<std::string>();
+            config.silent = true; // stdout carries the partial result only
+        }
+        if(parseResult.count("direct-io")){
+            config.directIo = parseResult["direct-io"].as<bool>();
+        }
+        if(parseResult.count("max-read-rate")){
+            config.maxReadRateInput = parseResult["max-read-rate"].as<std::string>();
+        }
+        if(parseResult.count("cpu-budget")){
+            config.cpuBudgetInput = parseResult["cpu-budget"].as<std::string>();
+        }
+        if(parseResult.count("nice")){
+            config.niceness = parseResult["nice"].as<int>();
+        }
+        if(parseResult.count("io-priority")){
+            config.ioPriorityInput = parseResult["io-priority"].as<std::string>();
+        }
+        if(parseResult.count("explain")){
+            config.explain = parseResult["explain"].as<bool>();
+        }
+        if(parseResult.count("stats")){
+            config.stats = parseResult["stats"].as<bool>();
+        }
         if(parseResult.count("format")){
             std::string formatString{parseResult["format"].as<std::string>()};
             if(formatString == "json"){
@@ -61,8 +200,11 @@ int main(int argumentCount, char *arguments[]){
             }else if(formatString == "keyvalue"){
                 config.outputFormat = OutputFormat::KEYVALUE;
                 config.silent = true;
+            }else if(formatString == "openmetrics"){
+                config.outputFormat = OutputFormat::OPENMETRICS;
+                config.silent = true;
             }else if(formatString != "text"){
-                throw std::invalid_argument{"Invalid format. Choose from: text, json, csv, or keyvalue"};
+                throw std::invalid_argument{"Invalid format. Choose from: text, json, csv, keyvalue, or openmetrics"};
             }
         }
         if(parseResult.count("silent")){
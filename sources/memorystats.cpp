@@ -0,0 +1,93 @@
+#include "memorystats.hpp"
+
+#include <array>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#if defined(__unix__) || defined(__APPLE__)
+    #include <sys/resource.h>
+#endif
+
+namespace{
+
+#if defined(ALLOCATION_ACCOUNTING)
+    constexpr std::size_t PhaseCount{static_cast<std::size_t>(MemoryStats::Phase::COUNT)};
+
+    // constant initialized, so allocations made before main() are counted safely
+    std::array<std::atomic<long long int>, PhaseCount> allocationCounts{};
+    std::array<std::atomic<long long int>, PhaseCount> allocatedBytes{};
+    thread_local MemoryStats::Phase currentPhase{MemoryStats::Phase::SETUP};
+#endif
+
+} // namespace
+
+#if defined(ALLOCATION_ACCOUNTING)
+void *operator new(std::size_t size){
+    const std::size_t phaseIndex{static_cast<std::size_t>(currentPhase)};
+    allocationCounts[phaseIndex].fetch_add(1, std::memory_order_relaxed);
+    allocatedBytes[phaseIndex].fetch_add(static_cast<long long int>(size), std::memory_order_relaxed);
+
+    if(size == 0) size = 1;
+    while(true){
+        if(void *memory{std::malloc(size)}) return memory;
+
+        const std::new_handler handler{std::get_new_handler()};
+        if(!handler) throw std::bad_alloc{};
+        handler();
+    }
+}
+
+// the nothrow forms forward to these by default, the aligned forms keep their own pairs uncounted
+void *operator new[](std::size_t size){ return ::operator new(size); }
+void operator delete(void *memory) noexcept{ std::free(memory); }
+void operator delete[](void *memory) noexcept{ std::free(memory); }
+void operator delete(void *memory, std::size_t) noexcept{ std::free(memory); }
+void operator delete[](void *memory, std::size_t) noexcept{ std::free(memory); }
+#endif
+
+namespace MemoryStats{
+
+    const char *phaseName(const Phase phase){
+        switch(phase){
+            case Phase::SETUP: return "setup";
+            case Phase::WARM_UP: return "warm-up";
+            case Phase::DATA_ROWS: return "data rows";
+            case Phase::RESULTS: return "results";
+            default: return "unknown";
+        }
+    }
+
+#if defined(ALLOCATION_ACCOUNTING)
+    void enterPhase(const Phase phase){
+        currentPhase = phase;
+    }
+
+    AllocationCounters allocationCounters(const Phase phase){
+        const std::size_t phaseIndex{static_cast<std::size_t>(phase)};
+        return {
+            allocationCounts[phaseIndex].load(std::memory_order_relaxed),
+            allocatedBytes[phaseIndex].load(std::memory_order_relaxed)
+        };
+    }
+#else
+    AllocationCounters allocationCounters(Phase){
+        return {};
+    }
+#endif
+
+    std::optional<long long int> peakResidentBytes(){
+#if defined(__unix__) || defined(__APPLE__)
+        rusage usage{};
+        if(::getrusage(RUSAGE_SELF, &usage) != 0) return std::nullopt;
+    #if defined(__APPLE__)
+        return static_cast<long long int>(usage.ru_maxrss); // already in bytes
+    #else
+        return static_cast<long long int>(usage.ru_maxrss) * 1024;
+    #endif
+#else
+        return std::nullopt;
+#endif
+    }
+
+} // namespace MemoryStats
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstddef>
+#include <optional>
+
+// Heap and resident memory figures for --stats.
+//
+// Allocations are only counted in builds configured with -DALLOCATION_ACCOUNTING=ON, which
+// replace the global operator new. Each thread attributes its allocations to the phase it last
+// entered, so the progress display on the main thread never shows up in the data rows of the
+// scanning thread. In regular builds entering a phase compiles to nothing.
+namespace MemoryStats{
+
+    enum class Phase{
+        SETUP,     // everything before the first data row, and threads that never enter a phase
+        WARM_UP,   // the first data rows, while reused buffers grow to the widest cells
+        DATA_ROWS, // every later data row, expected not to allocate at all
+        RESULTS,   // concluding and formatting the results
+        COUNT
+    };
+
+    struct AllocationCounters{
+        long long int allocations{0};
+        long long int bytes{0};
+    };
+
+    const char *phaseName(Phase phase);
+
+#if defined(ALLOCATION_ACCOUNTING)
+    constexpr bool countsAllocations{true};
+    void enterPhase(Phase phase);
+#else
+    constexpr bool countsAllocations{false};
+    inline void enterPhase(Phase){}
+#endif
+    AllocationCounters allocationCounters(Phase phase);
+
+    std::optional<long long int> peakResidentBytes(); // empty where the platform does not tell
+
+} // namespace MemoryStats
@@ -3,14 +3,21 @@
 #include <fmt/chrono.h>
 #include <fmt/core.h>
 
-#include <csv.h>
+#include <cmath>
 #include <iostream>
 #include <nlohmann/json.hpp>
 
 #include "constants.hpp"
+#include "memorystats.hpp"
+
+NaNalyzer::~NaNalyzer(){
+	stopPrescan();
+}
 
 int NaNalyzer::run(const CLIConfig &config){
 	silentMode_ = config.silent;
+	statsEnabled_ = config.stats;
+	directIo_ = config.directIo;
 	outputFormat_ = config.outputFormat;
 
 	if(!silentMode_){
@@ -18,8 +25,110 @@ int NaNalyzer::run(const CLIConfig &config){
 	}
 
 	try{
-		
-		if(config.configFilePath.has_value()){ // --config
+
+		// lowered before anything is read, the pre-scan and scanning threads started later inherit both
+		if(config.niceness.has_value()){
+			if(config.niceness.value() < -20 || config.niceness.value() > 19){
+				throw std::invalid_argument{fmt::format("Invalid nice value {}. Use -20 (highest priority) to 19 (lowest).", config.niceness.value())};
+			}
+			ScanThrottle::setNiceness(config.niceness.value());
+		}
+		if(config.ioPriorityInput.has_value()){
+			const std::string &ioPriorityString{config.ioPriorityInput.value()};
+			if(ioPriorityString == "idle"){
+				ScanThrottle::setIoPriority(ScanThrottle::IoPriorityClass::IDLE, 0);
+			}else if(ioPriorityString.starts_with("best-effort")){
+				const std::string levelString{ioPriorityString.substr(std::string_view{"best-effort"}.size())};
+				int level{4}; // the kernel's default within the class
+				if(!levelString.empty()){
+					if(levelString.size() != 2 || levelString.front() != ':' || levelString.back() < '0' || levelString.back() > '7'){
+						throw std::invalid_argument{fmt::format("Invalid I/O priority '{}'. Use best-effort:N with N from 0 (highest) to 7 (lowest).", ioPriorityString)};
+					}
+					level = levelString.back() - '0';
+				}
+				ScanThrottle::setIoPriority(ScanThrottle::IoPriorityClass::BEST_EFFORT, level);
+			}else{
+				throw std::invalid_argument{fmt::format("Invalid I/O priority '{}'. Choose from: idle, best-effort or best-effort:N.", ioPriorityString)};
+			}
+		}
+
+		if(config.maxReadRateInput.has_value() || config.cpuBudgetInput.has_value()){
+			std::optional<double> maxBytesPerSecond;
+			if(config.maxReadRateInput.has_value()){
+				const std::string &rateString{config.maxReadRateInput.value()};
+				double megabytesPerSecond{0.0};
+				try{
+					std::size_t parsedLength{0};
+					megabytesPerSecond = std::stod(rateString, &parsedLength);
+					if(parsedLength != rateString.size()) throw std::invalid_argument{"trailing characters"};
+				}catch(const std::exception &){
+					megabytesPerSecond = 0.0;
+				}
+				if(!(megabytesPerSecond > 0.0)){
+					throw std::invalid_argument{fmt::format("Invalid read rate '{}'. Use a positive number of megabytes per second (e.g., 50 or 0.5).", rateString)};
+				}
+				maxBytesPerSecond = megabytesPerSecond * 1024.0 * 1024.0;
+			}
+
+			std::optional<double> cpuBudget;
+			if(config.cpuBudgetInput.has_value()){
+				std::string budgetString{config.cpuBudgetInput.value()};
+				const bool isPercentage{budgetString.ends_with('%')};
+				if(isPercentage) budgetString.pop_back();
+
+				double budget{0.0};
+				try{
+					std::size_t parsedLength{0};
+					budget = std::stod(budgetString, &parsedLength);
+					if(parsedLength != budgetString.size()) throw std::invalid_argument{"trailing characters"};
+				}catch(const std::exception &){
+					budget = 0.0;
+				}
+				if(isPercentage) budget /= 100.0;
+				if(!(budget > 0.0)){
+					throw std::invalid_argument{fmt::format("Invalid CPU budget '{}'. Use a positive share of one core (e.g., 0.25 or 25%).", config.cpuBudgetInput.value())};
+				}
+				cpuBudget = budget;
+			}
+
+			scanThrottle_ = std::make_shared<ScanThrottle>(maxBytesPerSecond, cpuBudget);
+		}
+
+		if(config.delimiterInput.has_value() || config.quoteInput.has_value() || config.noTrim){
+			if(config.delimiterInput.has_value()){
+				const std::string &delimiterString{config.delimiterInput.value()};
+				if(delimiterString == "tab" || delimiterString == "\\t"){
+					dialect_.delimiter = '\t';
+				}else if(delimiterString.size() == 1){
+					dialect_.delimiter = delimiterString.front();
+				}else{
+					throw std::invalid_argument{fmt::format("Invalid delimiter '{}'. Use a single character or 'tab'.", delimiterString)};
+				}
+			}
+
+			if(config.quoteInput.has_value()){
+				const std::string &quoteString{config.quoteInput.value()};
+				if(quoteString.empty() || quoteString == "none"){
+					dialect_.quote = '\0';
+				}else if(quoteString.size() == 1){
+					dialect_.quote = quoteString.front();
+				}else{
+					throw std::invalid_argument{fmt::format("Invalid quote '{}'. Use a single character or 'none'.", quoteString)};
+				}
+			}
+
+			if(config.noTrim) dialect_.trim = false;
+
+			visitRowTokenizer(dialect_, [](auto){}); // rejects dialects without a compiled tokenizer
+			dialectSetFromCli_ = true;
+		}
+
+		if(!config.mergeInputs.empty()){ // merge
+			loadPartialConfiguration(config.mergeInputs.front());
+			if(!silentMode_){
+				fmt::println("Loaded configuration from partial result '{}'.", config.mergeInputs.front());
+			}
+		}else if(config.configFilePath.has_value()){ // --config
 			try{
 				loadInitializationFromJson(config.configFilePath.value());
 				if(!silentMode_){
@@ -35,24 +144,7 @@ int NaNalyzer::run(const CLIConfig &config){
 		}else if(config.csvFilePath.has_value()){ // --csv			
 			csvFilePath_ = config.csvFilePath.value();
 
-			io::LineReader csvLineReader{csvFilePath_};
-			try{
-				char *headerLine{csvLineReader.next_line()};
-				if(!headerLine){
-					throw std::runtime_error{"No header line found in CSV file."};
-				}
-				headers_ = splitString(std::string{headerLine}, ',');
-			}catch(const std::exception &exception){
-				throw std::runtime_error{fmt::format(
-					"Could not open or read file '{}'. {}",
-					csvFilePath_,
-					exception.what()
-				)};
-			}
-
-			if(headers_.empty()){
-				throw std::runtime_error{"No header line found in CSV file."};
-			}
+			headers_ = readCsvHeader(csvFilePath_);
 
 			if(!silentMode_){
 				fmt::println("Source CSV file: {}", csvFilePath_);
@@ -170,14 +262,90 @@ int NaNalyzer::run(const CLIConfig &config){
 			if(!silentMode_) fmt::println("Invalid values configured.");
 		}
 
+		if(!config.invalidPatternInputs.empty()){
+			if(!silentMode_){
+				fmt::println("\n--- Processing invalid patterns from CLI ---");
+			}
+
+			std::unordered_set<int> updatedFieldNumbers;
+			for(const std::string &patternInput : config.invalidPatternInputs){
+				const std::size_t separatorPosition{patternInput.find('=')};
+				if(separatorPosition == std::string::npos){
+					throw std::runtime_error{fmt::format("Invalid pattern '{}'. Expected field=pattern.", patternInput)};
+				}
+
+				int fieldNumber{0};
+				try{
+					fieldNumber = std::stoi(patternInput.substr(0, separatorPosition));
+				}catch(const std::exception &){
+					throw std::runtime_error{fmt::format("Invalid field number in pattern '{}'.", patternInput)};
+				}
+
+				if(!columns_.contains(fieldNumber)){
+					throw std::runtime_error{fmt::format("Field {} not in selected columns.", fieldNumber)};
+				}
+
+				columns_.at(fieldNumber).invalidPatterns.push_back(patternInput.substr(separatorPosition + 1));
+				updatedFieldNumbers.insert(fieldNumber);
+			}
+
+			for(const int fieldNumber : updatedFieldNumbers){
+				Column &columnDefinition{columns_.at(fieldNumber)};
+				columnDefinition.invalidPatternMatcher = PatternMatcher{columnDefinition.invalidPatterns};
+			}
+
+			if(!silentMode_) fmt::println("Invalid patterns configured.");
+		}
+
+		if(!config.typeRuleInputs.empty()){
+			if(!silentMode_){
+				fmt::println("\n--- Processing type rules from CLI ---");
+			}
+
+			for(const std::string &typeRuleInput : config.typeRuleInputs){
+				const std::size_t separatorPosition{typeRuleInput.find('=')};
+				if(separatorPosition == std::string::npos){
+					throw std::runtime_error{fmt::format("Invalid type rule '{}'. Expected field=type[:min..max].", typeRuleInput)};
+				}
+
+				int fieldNumber{0};
+				try{
+					fieldNumber = std::stoi(typeRuleInput.substr(0, separatorPosition));
+				}catch(const std::exception &){
+					throw std::runtime_error{fmt::format("Invalid field number in type rule '{}'.", typeRuleInput)};
+				}
+
+				if(!columns_.contains(fieldNumber)){
+					throw std::runtime_error{fmt::format("Field {} not in selected columns.", fieldNumber)};
+				}
+
+				columns_.at(fieldNumber).typeRule = TypeRule{std::string_view{typeRuleInput}.substr(separatorPosition + 1)};
+			}
+
+			if(!silentMode_) fmt::println("Type rules configured.");
+		}
+
+		if(!config.whereInputs.empty()){
+			if(!silentMode_){
+				fmt::println("\n--- Processing row filters from CLI ---");
+			}
+
+			for(const std::string &whereInput : config.whereInputs){
+				rowFilters_.emplace_back(whereInput, headers_);
+			}
+
+			if(!silentMode_) fmt::println("Only rows matching {} filter(s) are counted.", rowFilters_.size());
+		}
+
 		if(columnCombinationsToCheck_.empty() && !config.combinationsInput.has_value()){
 			if(config.csvFilePath.has_value()){
-				ColumnCombination defaultCombination;
+				std::vector<ColumnDisjunction> defaultClauses;
 				for(const auto &columnEntry : columns_){
 					ColumnDisjunction clause;
 					clause.push_back(columnEntry.second.index);
-					defaultCombination.push_back(std::move(clause));
+					defaultClauses.push_back(std::move(clause));
 				}
+				ColumnCombination defaultCombination{RuleExpression::fromClauses(defaultClauses)};
 				if(!defaultCombination.empty()){
 					columnCombinationsToCheck_.push_back(std::move(defaultCombination));
 				}
@@ -193,7 +361,7 @@ int NaNalyzer::run(const CLIConfig &config){
 			}
 
 			const std::string &combinationString{config.combinationsInput.value()};
-			DelimitedStringList combinationGroups{splitString(combinationString, ',')};
+			DelimitedStringList combinationGroups{splitCombinationList(combinationString)};
 
 			for(const std::string &groupString : combinationGroups){
 				const std::string trimmedGroup{[&groupString](){
@@ -207,58 +375,7 @@ int NaNalyzer::run(const CLIConfig &config){
 
 				if(trimmedGroup.empty()) continue;
 
-			ColumnCombination combination;
-			DelimitedStringList andParts{splitString(trimmedGroup, ':')};
-
-			for(const std::string &andPart : andParts){
-				const std::string trimmedAndPart{[&andPart](){
-						const std::size_t firstNonWhitespace{andPart.find_first_not_of(" \t\n\r")};
-						if(firstNonWhitespace == std::string::npos){
-							return std::string{};
-						}
-						const std::size_t lastNonWhitespace{andPart.find_last_not_of(" \t\n\r")};
-						return andPart.substr(firstNonWhitespace, lastNonWhitespace - firstNonWhitespace + 1);
-					}()};
-
-				ColumnDisjunction clause;
-				DelimitedStringList orParts{splitString(trimmedAndPart, '/')};
-
-				for(const std::string &orPart : orParts){
-						const std::string trimmedOrPart{[&orPart](){
-							const std::size_t firstNonWhitespace{orPart.find_first_not_of(" \t\n\r")};
-							if(firstNonWhitespace == std::string::npos){
-								return std::string{};
-							}
-							const std::size_t lastNonWhitespace{orPart.find_last_not_of(" \t\n\r")};
-							return orPart.substr(firstNonWhitespace, lastNonWhitespace - firstNonWhitespace + 1);
-						}()};
-
-						if(trimmedOrPart.empty()) continue;
-
-						try{
-							int fieldNumber{std::stoi(trimmedOrPart)};
-							int zeroBasedIndex{fieldNumber - 1};
-
-							if(zeroBasedIndex < 0 || zeroBasedIndex >= static_cast<int>(headers_.size())){
-								throw std::runtime_error{fmt::format("Field {} is out of range.", fieldNumber)};
-							}
-
-							if(!columns_.contains(fieldNumber)){
-								throw std::runtime_error{fmt::format("Field {} not in selected columns.", fieldNumber)};
-							}
-
-							clause.push_back(zeroBasedIndex);
-						}catch(const std::exception &exception){
-							throw std::runtime_error{fmt::format("Invalid field in combination '{}': {}", trimmedOrPart, exception.what())};
-						}
-					}
-
-					if(!clause.empty()){
-						std::sort(clause.begin(), clause.end());
-						clause.erase(std::unique(clause.begin(), clause.end()), clause.end());
-						combination.push_back(std::move(clause));
-					}
-				}
+				ColumnCombination combination{parseCombinationString(trimmedGroup)};
 
 				if(!combination.empty()){
 					columnCombinationsToCheck_.push_back(std::move(combination));
@@ -274,9 +391,273 @@ int NaNalyzer::run(const CLIConfig &config){
 			}
 		}
 
+		if(config.groupByInput.has_value()){
+			const std::string &groupByString{config.groupByInput.value()};
+			const auto headerMatch{std::find(headers_.begin(), headers_.end(), groupByString)};
+
+			if(headerMatch != headers_.end()){
+				groupByColumn_ = static_cast<ColumnOffset>(headerMatch - headers_.begin());
+			}else{
+				try{
+					const int fieldNumber{std::stoi(groupByString)};
+					if(fieldNumber < 1 || fieldNumber > static_cast<int>(headers_.size())){
+						throw std::runtime_error{fmt::format("Field {} is out of range.", fieldNumber)};
+					}
+					groupByColumn_ = fieldNumber - 1;
+				}catch(const std::exception &exception){
+					throw std::runtime_error{fmt::format("Invalid group-by field '{}': {}", groupByString, exception.what())};
+				}
+			}
+		}
+
+		if(config.distinctOnInput.has_value()){
+			distinctOnColumns_.clear();
+			for(const std::string &distinctField : splitString(config.distinctOnInput.value(), ',')){
+				if(distinctField.empty()) continue;
+
+				const auto headerMatch{std::find(headers_.begin(), headers_.end(), distinctField)};
+				if(headerMatch != headers_.end()){
+					distinctOnColumns_.push_back(static_cast<ColumnOffset>(headerMatch - headers_.begin()));
+					continue;
+				}
+
+				try{
+					const int fieldNumber{std::stoi(distinctField)};
+					if(fieldNumber < 1 || fieldNumber > static_cast<int>(headers_.size())){
+						throw std::runtime_error{fmt::format("Field {} is out of range.", fieldNumber)};
+					}
+					distinctOnColumns_.push_back(fieldNumber - 1);
+				}catch(const std::exception &exception){
+					throw std::runtime_error{fmt::format("Invalid distinct-on field '{}': {}", distinctField, exception.what())};
+				}
+			}
+
+			if(distinctOnColumns_.empty()){
+				throw std::runtime_error{"No valid distinct-on fields were given."};
+			}
+		}
+
+		if(config.distinctModeInput.has_value()){
+			const std::string &distinctModeString{config.distinctModeInput.value()};
+			if(distinctModeString == "exact"){
+				distinctMode_ = DistinctMode::EXACT;
+			}else if(distinctModeString == "hll" || distinctModeString == "hyperloglog"){
+				distinctMode_ = DistinctMode::HYPERLOGLOG;
+			}else{
+				throw std::invalid_argument{fmt::format("Invalid distinct mode '{}'. Choose from: exact or hll.", distinctModeString)};
+			}
+
+			if(distinctOnColumns_.empty()){
+				throw std::runtime_error{"--distinct-mode needs --distinct-on."};
+			}
+		}
+
+		if(config.windowInput.has_value()){
+			std::string windowString{config.windowInput.value()};
+			std::transform(
+				windowString.begin(), windowString.end(), windowString.begin(),
+				[](unsigned char character){ return static_cast<char>(std::tolower(character)); }
+			);
+
+			WindowConfig windowConfig{0, WindowUnit::ROWS};
+			if(windowString.ends_with("mb")){
+				windowConfig.unit = WindowUnit::BYTES;
+				windowString.resize(windowString.size() - 2);
+			}
+
+			try{
+				std::size_t parsedLength{0};
+				windowConfig.size = std::stoll(windowString, &parsedLength);
+				if(parsedLength != windowString.size() || windowConfig.size < 1){
+					throw std::runtime_error{"Window size must be a positive number of rows or megabytes (e.g., 100000 or 64MB)."};
+				}
+			}catch(const std::exception &exception){
+				throw std::runtime_error{fmt::format("Invalid window '{}': {}", config.windowInput.value(), exception.what())};
+			}
+
+			if(windowConfig.unit == WindowUnit::BYTES) windowConfig.size *= 1024 * 1024;
+			window_ = windowConfig;
+		}
+
+		if(config.cacheFilePath.has_value()){
+			cacheFilePath_ = config.cacheFilePath.value();
+		}
+
+		if(config.followInput.has_value()){
+			double followSeconds{0.0};
+			try{
+				std::size_t parsedLength{0};
+				followSeconds = std::stod(config.followInput.value(), &parsedLength);
+				if(parsedLength != config.followInput->size() || !(followSeconds > 0.0)){
+					throw std::runtime_error{"The publish interval must be a positive number of seconds."};
+				}
+			}catch(const std::exception &exception){
+				throw std::runtime_error{fmt::format("Invalid follow interval '{}': {}", config.followInput.value(), exception.what())};
+			}
+
+			followInterval_ = std::chrono::milliseconds{std::max<long long int>(1, std::llround(followSeconds * 1000.0))};
+		}
+
+		if(config.failedRowsFilePath.has_value()){
+			failedRowsFilePath_ = config.failedRowsFilePath.value();
+		}
+
+		if(config.splitCombinationInput.has_value()){
+			ColumnCombination splitCombination{parseCombinationString(config.splitCombinationInput.value())};
+			if(splitCombination.empty()){
+				throw std::runtime_error{fmt::format("Invalid split combination '{}'.", config.splitCombinationInput.value())};
+			}
+
+			// reuse an identical combination that is already being checked, otherwise check it as well
+			const auto existingCombination{std::find(columnCombinationsToCheck_.begin(), columnCombinationsToCheck_.end(), splitCombination)};
+			if(existingCombination != columnCombinationsToCheck_.end()){
+				splitCombinationIndex_ = static_cast<std::size_t>(existingCombination - columnCombinationsToCheck_.begin());
+			}else{
+				splitCombinationIndex_ = columnCombinationsToCheck_.size();
+				columnCombinationsToCheck_.push_back(std::move(splitCombination));
+			}
+		}
+
+		for(const std::string &failUnderString : config.failUnderInputs){
+			const std::size_t separatorPosition{failUnderString.rfind('=')};
+			if(separatorPosition == std::string::npos){
+				throw std::runtime_error{fmt::format("Invalid quality gate '{}'. Use combination=ratio (e.g., 1:2=0.98).", failUnderString)};
+			}
+
+			ColumnCombination gateCombination{parseCombinationString(failUnderString.substr(0, separatorPosition))};
+			if(gateCombination.empty()){
+				throw std::runtime_error{fmt::format("Invalid quality gate combination in '{}'.", failUnderString)};
+			}
+
+			std::string ratioString{failUnderString.substr(separatorPosition + 1)};
+			const bool isPercentage{ratioString.ends_with('%')};
+			if(isPercentage) ratioString.pop_back();
+
+			double minimumCompleteness{0.0};
+			try{
+				std::size_t parsedLength{0};
+				minimumCompleteness = std::stod(ratioString, &parsedLength);
+				if(parsedLength != ratioString.size()) throw std::invalid_argument{"trailing characters"};
+			}catch(const std::exception &){
+				throw std::runtime_error{fmt::format("Invalid quality gate ratio in '{}'.", failUnderString)};
+			}
+			if(isPercentage) minimumCompleteness /= 100.0;
+			if(minimumCompleteness < 0.0 || minimumCompleteness > 1.0){
+				throw std::runtime_error{fmt::format("Quality gate ratio in '{}' must be between 0 and 1 (or 0% and 100%).", failUnderString)};
+			}
+
+			// same as --split: gate an identical combination that is already being checked, otherwise check it as well
+			const auto existingCombination{std::find(columnCombinationsToCheck_.begin(), columnCombinationsToCheck_.end(), gateCombination)};
+			const std::size_t combinationIndex{static_cast<std::size_t>(existingCombination - columnCombinationsToCheck_.begin())};
+			if(existingCombination == columnCombinationsToCheck_.end()){
+				if(!config.mergeInputs.empty()){
+					throw std::runtime_error{fmt::format("Quality gate '{}' must name a combination the partial results counted.", failUnderString)};
+				}
+				columnCombinationsToCheck_.push_back(std::move(gateCombination));
+			}
+
+			qualityGates_.push_back({combinationIndex, minimumCompleteness});
+		}
+
+		if(config.earlyExitInput.has_value()){
+			const std::string &earlyExitString{config.earlyExitInput.value()};
+			if(earlyExitString == "exact"){
+				earlyExitMode_ = EarlyExitMode::EXACT;
+			}else if(earlyExitString == "sequential"){
+				earlyExitMode_ = EarlyExitMode::SEQUENTIAL;
+			}else{
+				throw std::invalid_argument{fmt::format("Invalid early exit mode '{}'. Choose from: exact or sequential.", earlyExitString)};
+			}
+
+			if(qualityGates_.empty()){
+				throw std::runtime_error{"--early-exit needs at least one --fail-under gate."};
+			}
+			if(failedRowsFilePath_.has_value() || splitCombinationIndex_.has_value()){
+				throw std::runtime_error{"--early-exit cannot be combined with --failed-rows or --split, which need every row."};
+			}
+		}
+
+		if(followInterval_.has_value()){
+			// byte offsets and the cache stamp describe one fixed file, a followed one grows and rotates
+			if(failedRowsFilePath_.has_value() || splitCombinationIndex_.has_value() || cacheFilePath_.has_value()){
+				throw std::runtime_error{"--follow cannot be combined with --failed-rows, --split or --cache."};
+			}
+			if(earlyExitMode_ != EarlyExitMode::NONE){
+				throw std::runtime_error{"--follow cannot be combined with --early-exit, a followed file has no end to decide against."};
+			}
+		}
+
+		if(config.byteRangeInput.has_value()){
+			const std::string &byteRangeString{config.byteRangeInput.value()};
+			const std::size_t separatorPosition{byteRangeString.find(':')};
+
+			ByteRange byteRange{0, std::numeric_limits<long long int>::max()};
+			try{
+				if(separatorPosition == std::string::npos) throw std::invalid_argument{"missing ':'"};
+
+				const std::string beginString{byteRangeString.substr(0, separatorPosition)};
+				const std::string endString{byteRangeString.substr(separatorPosition + 1)};
+
+				std::size_t parsedLength{0};
+				byteRange.begin = std::stoll(beginString, &parsedLength);
+				if(parsedLength != beginString.size()) throw std::invalid_argument{"trailing characters"};
+
+				if(!endString.empty()){
+					byteRange.end = std::stoll(endString, &parsedLength);
+					if(parsedLength != endString.size()) throw std::invalid_argument{"trailing characters"};
+				}
+			}catch(const std::exception &){
+				throw std::runtime_error{fmt::format("Invalid byte range '{}'. Use START:END in bytes, END may be left out for the end of the file.", byteRangeString)};
+			}
+
+			if(byteRange.begin < 0 || byteRange.end < byteRange.begin){
+				throw std::runtime_error{fmt::format("Byte range '{}' must satisfy 0 <= START <= END.", byteRangeString)};
+			}
+			byteRange_ = byteRange;
+
+			// a partial holds counts to be merged, everything that needs the rows or the whole file stays with a full scan
+			if(failedRowsFilePath_.has_value() || splitCombinationIndex_.has_value() || cacheFilePath_.has_value() || window_.has_value() || followInterval_.has_value()){
+				throw std::runtime_error{"--byte-range cannot be combined with --failed-rows, --split, --cache, --window or --follow."};
+			}
+			if(!qualityGates_.empty()){
+				throw std::runtime_error{"--byte-range cannot be combined with --fail-under, pass the gates to merge instead."};
+			}
+			if(!distinctOnColumns_.empty() && distinctMode_ != DistinctMode::HYPERLOGLOG){
+				throw std::runtime_error{"--byte-range needs --distinct-mode hll, exact distinct entities cannot be merged."};
+			}
+		}
+
+		if(config.baselineFilePath.has_value()){
+			// the comparison needs both files read to their end under the same rows
+			if(followInterval_.has_value() || byteRange_.has_value() || earlyExitMode_ != EarlyExitMode::NONE){
+				throw std::runtime_error{"--baseline cannot be combined with --follow, --byte-range or --early-exit."};
+			}
+			baselineFilePath_ = config.baselineFilePath.value();
+		}
+
+		if(config.profileValuesInput.has_value()){
+			// a shard's profiles travel in its partial result, merge combines them and saves the file
+			if(byteRange_.has_value() && !config.profileValuesInput->empty()){
+				throw std::runtime_error{"--profile-values takes no file with --byte-range, give it to merge instead."};
+			}
+			valueProfilePath_ = config.profileValuesInput->empty() ? deriveValueProfilePath(csvFilePath_) : config.profileValuesInput.value();
+		}
+
+		if(config.metricsTextfilePath.has_value()){
+			metricsTextfilePath_ = config.metricsTextfilePath.value();
+		}
+
+		if(outputFormat_ == OutputFormat::OPENMETRICS && window_.has_value()){
+			throw std::runtime_error{"--window cannot be combined with --format openmetrics, use --metrics-textfile to follow a running scan."};
+		}
+
+		if(groupByColumn_.has_value() && !silentMode_){
+			fmt::println("Grouping results by field {} ({}).", groupByColumn_.value() + 1, headers_[groupByColumn_.value()]);
+		}
+
 		bool shouldProcess{true};
 
-		if(!config.configFilePath.has_value() && !config.csvFilePath.has_value()){
+		if(!config.configFilePath.has_value() && !config.csvFilePath.has_value() && config.mergeInputs.empty()){
 			if(configurationLoadedFromJson_){
 				fmt::print("\nProceed to processing the CSV now? (Y/n): ");
 				std::string response;
@@ -353,7 +734,15 @@ int NaNalyzer::run(const CLIConfig &config){
 		}
 
 		if(shouldProcess){
-			process();
+			if(!config.mergeInputs.empty()){
+				mergePartialResults(config.mergeInputs);
+			}else if(config.explain){
+				explain();
+				return 0;
+			}else{
+				process();
+			}
+			if(statsEnabled_) printScanStatistics();
 		}else if(!silentMode_){
 			fmt::println("Skipping processing per user request.");
 		}
@@ -363,66 +752,572 @@ int NaNalyzer::run(const CLIConfig &config){
 		return 1;
 	}
 
-	return 0;
+	return hasFailedQualityGate() ? Constants::QualityGateFailureExitCode : 0;
+}
+
+NaNalyzer::BaselineDelta NaNalyzer::compareWithBaseline(std::size_t combinationIndex, long long int totalRowCount) const{
+	const long long int baselineValidRowCount{baseline_->validCounts[combinationIndex]};
+	const long long int validRowCount{validCounts_[combinationIndex]};
+	const double baselineRowCount{static_cast<double>(baseline_->totalRowCount)};
+	const double rowCount{static_cast<double>(totalRowCount)};
+
+	BaselineDelta delta{0.0, 0.0, 0.0, false};
+	if(baselineRowCount > 0.0) delta.baselineCompleteness = static_cast<double>(baselineValidRowCount) / baselineRowCount;
+	if(rowCount > 0.0) delta.completeness = static_cast<double>(validRowCount) / rowCount;
+
+	// pooled two-proportion test: how many standard errors the change lies away from sampling noise
+	if(baselineRowCount > 0.0 && rowCount > 0.0){
+		const double pooledCompleteness{static_cast<double>(baselineValidRowCount + validRowCount) / (baselineRowCount + rowCount)};
+		const double standardError{std::sqrt(pooledCompleteness * (1.0 - pooledCompleteness) * (1.0 / baselineRowCount + 1.0 / rowCount))};
+		if(standardError > 0.0) delta.zScore = (delta.completeness - delta.baselineCompleteness) / standardError;
+	}
+
+	delta.isRegression = delta.zScore <= -Constants::BaselineRegressionZScore
+		&& delta.baselineCompleteness - delta.completeness >= Constants::BaselineMinimumRegression;
+	return delta;
+}
+
+std::string NaNalyzer::formatBaselineDelta(std::size_t combinationIndex, long long int totalRowCount) const{
+	const BaselineDelta delta{compareWithBaseline(combinationIndex, totalRowCount)};
+	return fmt::format(
+		"[{}] : {:.2f}% -> {:.2f}% ({:+.2f} pp, z = {:.1f}){}",
+		formatCombinationForDisplay(columnCombinationsToCheck_[combinationIndex]),
+		delta.baselineCompleteness * 100.0,
+		delta.completeness * 100.0,
+		(delta.completeness - delta.baselineCompleteness) * 100.0,
+		delta.zScore,
+		delta.isRegression ? " REGRESSION" : ""
+	);
 }
 
 std::string NaNalyzer::formatResultsAsJson(long long int totalRowCount) const{
+	const auto buildResultsArray{[this](const long long int rowCount, const long long int *validRowCounts){
+		nlohmann::json resultsArray = nlohmann::json::array();
+		for(std::size_t combinationIndex{0}; combinationIndex < columnCombinationsToCheck_.size(); combinationIndex++){
+			const long long int validRowCount{validRowCounts[combinationIndex]};
+			float completeness{.0f};
+			if(rowCount > 0){
+				completeness = static_cast<float>(validRowCount) / static_cast<float>(rowCount);
+			}
+
+			nlohmann::json resultObject;
+			resultObject["combination"] = formatCombinationForDisplay(columnCombinationsToCheck_[combinationIndex]);
+			resultObject["valid_rows"] = validRowCount;
+			resultObject["total_rows"] = rowCount;
+			resultObject["completeness"] = completeness;
+
+			resultsArray.push_back(std::move(resultObject));
+		}
+		return resultsArray;
+	}};
+
 	nlohmann::json root;
 	root["version"] = Constants::Version;
 	root["total_rows"] = totalRowCount;
-	
-	nlohmann::json resultsArray{nlohmann::json::array()};
-	for(std::size_t combinationIndex{0}; combinationIndex < columnCombinationsToCheck_.size(); combinationIndex++){
-		const long long int validRowCount{validCounts_[combinationIndex]};
-		float completeness{.0f};
-		if(totalRowCount > 0){
-			completeness = static_cast<float>(validRowCount) / static_cast<float>(totalRowCount);
+	root["results"] = buildResultsArray(totalRowCount, validCounts_.data());
+
+	if(groupByColumn_.has_value()){
+		root["group_by"] = headers_[groupByColumn_.value()];
+
+		nlohmann::json groupsArray = nlohmann::json::array();
+		for(std::size_t groupIndex{0}; groupIndex < groupKeys_.size(); groupIndex++){
+			nlohmann::json groupObject;
+			groupObject["group"] = std::string{groupKeys_[groupIndex]};
+			groupObject["total_rows"] = groupRowCounts_[groupIndex];
+			groupObject["results"] = buildResultsArray(
+				groupRowCounts_[groupIndex],
+				&groupValidCounts_[groupIndex * columnCombinationsToCheck_.size()]
+			);
+
+			groupsArray.push_back(std::move(groupObject));
 		}
+		root["groups"] = std::move(groupsArray);
+	}
 
-		nlohmann::json resultObject;
-		resultObject["combination"] = formatCombinationForDisplay(columnCombinationsToCheck_[combinationIndex]);
-		resultObject["valid_rows"] = validRowCount;
-		resultObject["total_rows"] = totalRowCount;
-		resultObject["completeness"] = completeness;
+	if(!distinctOnColumns_.empty()){
+		nlohmann::json distinctFieldNames = nlohmann::json::array();
+		for(const ColumnOffset columnOffset : distinctOnColumns_) distinctFieldNames.push_back(headers_[columnOffset]);
 
-		resultsArray.push_back(std::move(resultObject));
+		nlohmann::json distinctObject;
+		distinctObject["fields"] = std::move(distinctFieldNames);
+		distinctObject["mode"] = distinctMode_ == DistinctMode::HYPERLOGLOG ? "hll" : "exact";
+		distinctObject["total_entities"] = distinctEntityCount_;
+		distinctObject["results"] = buildResultsArray(distinctEntityCount_, distinctValidCounts_.data());
+		root["distinct"] = std::move(distinctObject);
 	}
-	root["results"] = std::move(resultsArray);
 
-	return root.dump(2);
+	if(!qualityGates_.empty()){
+		nlohmann::json gatesArray = nlohmann::json::array();
+		for(const QualityGate &gate : qualityGates_){
+			nlohmann::json gateObject;
+			gateObject["combination"] = formatCombinationForDisplay(columnCombinationsToCheck_[gate.combinationIndex]);
+			gateObject["minimum_completeness"] = gate.minimumCompleteness;
+			gateObject["status"] = gate.status == GateStatus::PASSED ? "passed" : "failed";
+			gateObject["decided_at_row"] = gate.decidedAtRow;
+
+			gatesArray.push_back(std::move(gateObject));
+		}
+		root["quality_gates"] = std::move(gatesArray);
+		root["stopped_early"] = stoppedEarly_;
+	}
+
+	if(!valueProfiles_.empty()){
+		root["value_profiles"] = valueProfilesToJson();
+	}
+
+	if(baseline_.has_value()){
+		nlohmann::json deltasArray = nlohmann::json::array();
+		for(std::size_t combinationIndex{0}; combinationIndex < columnCombinationsToCheck_.size(); combinationIndex++){
+			const BaselineDelta delta{compareWithBaseline(combinationIndex, totalRowCount)};
+
+			nlohmann::json deltaObject;
+			deltaObject["combination"] = formatCombinationForDisplay(columnCombinationsToCheck_[combinationIndex]);
+			deltaObject["baseline_completeness"] = delta.baselineCompleteness;
+			deltaObject["completeness"] = delta.completeness;
+			deltaObject["delta"] = delta.completeness - delta.baselineCompleteness;
+			deltaObject["z_score"] = delta.zScore;
+			deltaObject["regression"] = delta.isRegression;
+
+			deltasArray.push_back(std::move(deltaObject));
+		}
+
+		nlohmann::json baselineObject;
+		baselineObject["file"] = baseline_->csvFilePath;
+		baselineObject["total_rows"] = baseline_->totalRowCount;
+		baselineObject["from_saved_result"] = baseline_->fromCache;
+		baselineObject["results"] = std::move(deltasArray);
+		root["baseline"] = std::move(baselineObject);
+	}
+
+	// keep the summary on a single line so windowed and followed runs stay valid NDJSON
+	return root.dump(window_.has_value() || followInterval_.has_value() ? -1 : 2);
 }
 
 std::string NaNalyzer::formatResultsAsCsv(long long int totalRowCount) const{
-	std::string csvOutput;
-	for(std::size_t combinationIndex{0}; combinationIndex < columnCombinationsToCheck_.size(); combinationIndex++){
-		const long long int validRowCount{validCounts_[combinationIndex]};
-		float completeness{.0f};
-		if(totalRowCount > 0){
-			completeness = static_cast<float>(validRowCount) / static_cast<float>(totalRowCount);
+	const auto appendCompleteness{[this](std::string &csvOutput, const long long int rowCount, const long long int *validRowCounts){
+		for(std::size_t combinationIndex{0}; combinationIndex < columnCombinationsToCheck_.size(); combinationIndex++){
+			const long long int validRowCount{validRowCounts[combinationIndex]};
+			float completeness{.0f};
+			if(rowCount > 0){
+				completeness = static_cast<float>(validRowCount) / static_cast<float>(rowCount);
+			}
+
+			if(combinationIndex > 0) csvOutput += ',';
+
+			csvOutput += fmt::format("{:.2f}", completeness);
 		}
+	}};
+
+	std::string csvOutput;
+	appendCompleteness(csvOutput, totalRowCount, validCounts_.data());
 
-		if(combinationIndex > 0) csvOutput += ',';
+	// then one record per group: the group key followed by the completeness of every combination
+	for(std::size_t groupIndex{0}; groupIndex < groupKeys_.size(); groupIndex++){
+		csvOutput += '\n';
 
-		csvOutput += fmt::format("{:.2f}", completeness);
+		const GroupKey groupKey{groupKeys_[groupIndex]};
+		if(groupKey.find_first_of(",\"\n\r") != GroupKey::npos){
+			csvOutput += '"';
+			for(const char character : groupKey){
+				if(character == '"') csvOutput += '"';
+				csvOutput += character;
+			}
+			csvOutput += '"';
+		}else{
+			csvOutput += groupKey;
+		}
+		csvOutput += ',';
+
+		appendCompleteness(
+			csvOutput,
+			groupRowCounts_[groupIndex],
+			&groupValidCounts_[groupIndex * columnCombinationsToCheck_.size()]
+		);
 	}
 	return csvOutput;
 }
 
+namespace{
+
+	// values with spaces, '=' or quotes, or none at all, are quoted so a line still splits into its pairs
+	std::string formatKeyValueValue(std::string_view value){
+		if(!value.empty() && value.find_first_of(" \t\n\r=\"\\") == std::string_view::npos) return std::string{value};
+
+		std::string quotedValue{'"'};
+		for(const char character : value){
+			if(character == '\\' || character == '"'){
+				quotedValue += '\\';
+				quotedValue += character;
+			}else if(character == '\n'){
+				quotedValue += "\\n";
+			}else if(character == '\r'){
+				quotedValue += "\\r";
+			}else{
+				quotedValue += character;
+			}
+		}
+		quotedValue += '"';
+		return quotedValue;
+	}
+
+} // namespace
+
 std::string NaNalyzer::formatResultsAsKeyValue(long long int totalRowCount) const{
-	std::string keyValueOutput;
-	for(std::size_t combinationIndex{0}; combinationIndex < columnCombinationsToCheck_.size(); combinationIndex++){
-		const long long int validRowCount{validCounts_[combinationIndex]};
-		float completeness{.0f};
-		if(totalRowCount > 0){
-			completeness = static_cast<float>(validRowCount) / static_cast<float>(totalRowCount);
+	const auto appendCompleteness{[this](std::string &keyValueOutput, const long long int rowCount, const long long int *validRowCounts){
+		for(std::size_t combinationIndex{0}; combinationIndex < columnCombinationsToCheck_.size(); combinationIndex++){
+			const long long int validRowCount{validRowCounts[combinationIndex]};
+			float completeness{.0f};
+			if(rowCount > 0){
+				completeness = static_cast<float>(validRowCount) / static_cast<float>(rowCount);
+			}
+
+			if(combinationIndex > 0) keyValueOutput += ' ';
+
+			// pairs are split at spaces, so expression rules are keyed without theirs
+			std::string key{formatCombinationForDisplay(columnCombinationsToCheck_[combinationIndex])};
+			std::erase(key, ' ');
+
+			keyValueOutput += fmt::format("{}={:.2f}", key, completeness);
 		}
+	}};
+
+	std::string keyValueOutput;
+	appendCompleteness(keyValueOutput, totalRowCount, validCounts_.data());
 
-		if(combinationIndex > 0) keyValueOutput += ' ';
-		
-		keyValueOutput += fmt::format("{}={:.2f}", 
-			formatCombinationForDisplay(columnCombinationsToCheck_[combinationIndex]),
-			completeness
+	for(std::size_t groupIndex{0}; groupIndex < groupKeys_.size(); groupIndex++){
+		keyValueOutput += fmt::format("\ngroup={} ", formatKeyValueValue(groupKeys_[groupIndex]));
+		appendCompleteness(
+			keyValueOutput,
+			groupRowCounts_[groupIndex],
+			&groupValidCounts_[groupIndex * columnCombinationsToCheck_.size()]
 		);
 	}
+
+	if(!distinctOnColumns_.empty()){
+		keyValueOutput += fmt::format("\ndistinct_entities={} ", distinctEntityCount_);
+		appendCompleteness(keyValueOutput, distinctEntityCount_, distinctValidCounts_.data());
+	}
 	return keyValueOutput;
 }
+
+namespace{
+
+	std::string escapeMetricLabel(std::string_view value){
+		std::string escapedValue;
+		escapedValue.reserve(value.size());
+		for(const char character : value){
+			if(character == '\\' || character == '"'){
+				escapedValue += '\\';
+				escapedValue += character;
+			}else if(character == '\n'){
+				escapedValue += "\\n";
+			}else{
+				escapedValue += character;
+			}
+		}
+		return escapedValue;
+	}
+
+	void appendMetricFamily(std::string &metrics, const std::string_view name, const std::string_view help){
+		metrics += fmt::format("# TYPE {} gauge\n# HELP {} {}\n", name, name, help);
+	}
+
+	void appendScanTelemetry(
+		std::string &metrics,
+		const std::string &fileLabel,
+		const long long int rowCount,
+		const long long int byteCount,
+		const long long int fileBytes,
+		const double elapsedSeconds,
+		const int threadCount,
+		const bool inProgress
+	){
+		const double rowsPerSecond{elapsedSeconds > 0.0 ? static_cast<double>(rowCount) / elapsedSeconds : 0.0};
+
+		appendMetricFamily(metrics, "csv_completeness_scan_in_progress", "Whether the scan is still running.");
+		metrics += fmt::format("csv_completeness_scan_in_progress{{{}}} {}\n", fileLabel, inProgress ? 1 : 0);
+		appendMetricFamily(metrics, "csv_completeness_scan_rows", "Data rows scanned so far.");
+		metrics += fmt::format("csv_completeness_scan_rows{{{}}} {}\n", fileLabel, rowCount);
+		appendMetricFamily(metrics, "csv_completeness_scan_bytes", "Bytes read from the CSV file, or from the columnar cache when it was used.");
+		metrics += fmt::format("csv_completeness_scan_bytes{{{}}} {}\n", fileLabel, byteCount);
+		appendMetricFamily(metrics, "csv_completeness_file_bytes", "Size of the CSV file.");
+		metrics += fmt::format("csv_completeness_file_bytes{{{}}} {}\n", fileLabel, fileBytes);
+		appendMetricFamily(metrics, "csv_completeness_scan_duration_seconds", "Time spent scanning.");
+		metrics += fmt::format("csv_completeness_scan_duration_seconds{{{}}} {:.6f}\n", fileLabel, elapsedSeconds);
+		appendMetricFamily(metrics, "csv_completeness_scan_rows_per_second", "Scan throughput.");
+		metrics += fmt::format("csv_completeness_scan_rows_per_second{{{}}} {:.1f}\n", fileLabel, rowsPerSecond);
+		appendMetricFamily(metrics, "csv_completeness_scan_threads", "Threads scanning the file.");
+		metrics += fmt::format("csv_completeness_scan_threads{{{}}} {}\n", fileLabel, threadCount);
+	}
+
+} // namespace
+
+std::string NaNalyzer::formatResultsAsOpenMetrics(long long int totalRowCount) const{
+	const std::string fileLabel{fmt::format("file=\"{}\"", escapeMetricLabel(csvFilePath_))};
+
+	// every sample of a family has to follow its TYPE line, so each family walks the overall
+	// results first and then every group
+	const auto appendSamples{[&](std::string &metrics, const std::string_view name, const auto &sampleValue){
+		const auto appendScope{[&](const std::string &scopeLabels, const long long int rowCount, const long long int *validRowCounts){
+			for(std::size_t combinationIndex{0}; combinationIndex < columnCombinationsToCheck_.size(); combinationIndex++){
+				metrics += fmt::format(
+					"{}{{{},combination=\"{}\"}} {}\n",
+					name,
+					scopeLabels,
+					escapeMetricLabel(formatCombinationForDisplay(columnCombinationsToCheck_[combinationIndex])),
+					sampleValue(rowCount, validRowCounts[combinationIndex])
+				);
+			}
+		}};
+
+		appendScope(fileLabel, totalRowCount, validCounts_.data());
+		for(std::size_t groupIndex{0}; groupIndex < groupKeys_.size(); groupIndex++){
+			appendScope(
+				fmt::format("{},group=\"{}\"", fileLabel, escapeMetricLabel(groupKeys_[groupIndex])),
+				groupRowCounts_[groupIndex],
+				&groupValidCounts_[groupIndex * columnCombinationsToCheck_.size()]
+			);
+		}
+	}};
+
+	std::string metrics;
+
+	appendMetricFamily(metrics, "csv_completeness_rows", "Data rows evaluated.");
+	metrics += fmt::format("csv_completeness_rows{{{}}} {}\n", fileLabel, totalRowCount);
+	for(std::size_t groupIndex{0}; groupIndex < groupKeys_.size(); groupIndex++){
+		metrics += fmt::format(
+			"csv_completeness_rows{{{},group=\"{}\"}} {}\n",
+			fileLabel,
+			escapeMetricLabel(groupKeys_[groupIndex]),
+			groupRowCounts_[groupIndex]
+		);
+	}
+
+	appendMetricFamily(metrics, "csv_completeness_valid_rows", "Rows satisfying the combination.");
+	appendSamples(metrics, "csv_completeness_valid_rows", [](const long long int, const long long int validRowCount){
+		return fmt::format("{}", validRowCount);
+	});
+
+	appendMetricFamily(metrics, "csv_completeness_ratio", "Share of rows satisfying the combination.");
+	appendSamples(metrics, "csv_completeness_ratio", [](const long long int rowCount, const long long int validRowCount){
+		return fmt::format("{:.6f}", rowCount > 0 ? static_cast<double>(validRowCount) / static_cast<double>(rowCount) : 0.0);
+	});
+
+	if(!distinctOnColumns_.empty()){
+		appendMetricFamily(metrics, "csv_completeness_distinct_entities", "Distinct entities, estimated in hll mode.");
+		metrics += fmt::format("csv_completeness_distinct_entities{{{}}} {}\n", fileLabel, distinctEntityCount_);
+
+		appendMetricFamily(metrics, "csv_completeness_distinct_valid_entities", "Distinct entities with a row satisfying the combination.");
+		for(std::size_t combinationIndex{0}; combinationIndex < columnCombinationsToCheck_.size(); combinationIndex++){
+			metrics += fmt::format(
+				"csv_completeness_distinct_valid_entities{{{},combination=\"{}\"}} {}\n",
+				fileLabel,
+				escapeMetricLabel(formatCombinationForDisplay(columnCombinationsToCheck_[combinationIndex])),
+				distinctValidCounts_[combinationIndex]
+			);
+		}
+
+		appendMetricFamily(metrics, "csv_completeness_distinct_ratio", "Share of distinct entities with a row satisfying the combination.");
+		for(std::size_t combinationIndex{0}; combinationIndex < columnCombinationsToCheck_.size(); combinationIndex++){
+			const long long int validEntityCount{distinctValidCounts_[combinationIndex]};
+			metrics += fmt::format(
+				"csv_completeness_distinct_ratio{{{},combination=\"{}\"}} {:.6f}\n",
+				fileLabel,
+				escapeMetricLabel(formatCombinationForDisplay(columnCombinationsToCheck_[combinationIndex])),
+				distinctEntityCount_ > 0 ? static_cast<double>(validEntityCount) / static_cast<double>(distinctEntityCount_) : 0.0
+			);
+		}
+	}
+
+	if(!qualityGates_.empty()){
+		appendMetricFamily(metrics, "csv_completeness_gate_passed", "Whether the combination met its --fail-under minimum.");
+		for(const QualityGate &gate : qualityGates_){
+			metrics += fmt::format(
+				"csv_completeness_gate_passed{{{},combination=\"{}\",minimum=\"{}\"}} {}\n",
+				fileLabel,
+				escapeMetricLabel(formatCombinationForDisplay(columnCombinationsToCheck_[gate.combinationIndex])),
+				gate.minimumCompleteness,
+				gate.status == GateStatus::PASSED ? 1 : 0
+			);
+		}
+	}
+
+	if(baseline_.has_value()){
+		const std::string baselineLabel{fmt::format("{},baseline=\"{}\"", fileLabel, escapeMetricLabel(baseline_->csvFilePath))};
+
+		appendMetricFamily(metrics, "csv_completeness_baseline_ratio", "Share of the baseline's rows satisfying the combination.");
+		for(std::size_t combinationIndex{0}; combinationIndex < columnCombinationsToCheck_.size(); combinationIndex++){
+			metrics += fmt::format(
+				"csv_completeness_baseline_ratio{{{},combination=\"{}\"}} {:.6f}\n",
+				baselineLabel,
+				escapeMetricLabel(formatCombinationForDisplay(columnCombinationsToCheck_[combinationIndex])),
+				compareWithBaseline(combinationIndex, totalRowCount).baselineCompleteness
+			);
+		}
+
+		appendMetricFamily(metrics, "csv_completeness_baseline_regression", "Whether the combination's completeness dropped significantly below the baseline.");
+		for(std::size_t combinationIndex{0}; combinationIndex < columnCombinationsToCheck_.size(); combinationIndex++){
+			metrics += fmt::format(
+				"csv_completeness_baseline_regression{{{},combination=\"{}\"}} {}\n",
+				baselineLabel,
+				escapeMetricLabel(formatCombinationForDisplay(columnCombinationsToCheck_[combinationIndex])),
+				compareWithBaseline(combinationIndex, totalRowCount).isRegression ? 1 : 0
+			);
+		}
+	}
+
+	appendScanTelemetry(
+		metrics,
+		fileLabel,
+		totalRowCount,
+		scanTelemetry_.bytesRead,
+		scanTelemetry_.fileBytes,
+		scanTelemetry_.durationSeconds,
+		scanTelemetry_.threadCount,
+		false
+	);
+
+	metrics += "# EOF";
+	return metrics;
+}
+
+std::string NaNalyzer::formatProgressAsOpenMetrics(long long int rowCount, long long int byteCount, double elapsedSeconds) const{
+	std::string metrics;
+	appendScanTelemetry(
+		metrics,
+		fmt::format("file=\"{}\"", escapeMetricLabel(csvFilePath_)),
+		rowCount,
+		byteCount,
+		scanTelemetry_.fileBytes,
+		elapsedSeconds,
+		scanTelemetry_.threadCount,
+		true
+	);
+
+	metrics += "# EOF";
+	return metrics;
+}
+
+std::string NaNalyzer::formatWindowResult(
+	std::size_t windowIndex,
+	long long int firstRow,
+	long long int lastRow,
+	long long int windowRowCount,
+	long long int windowByteCount
+) const{
+	if(outputFormat_ == OutputFormat::JSON){ // one NDJSON record per window
+		nlohmann::json windowObject;
+		windowObject["window"] = windowIndex;
+		windowObject["first_row"] = firstRow;
+		windowObject["last_row"] = lastRow;
+		windowObject["total_rows"] = windowRowCount;
+		windowObject["bytes"] = windowByteCount;
+
+		nlohmann::json resultsArray = nlohmann::json::array();
+		for(std::size_t combinationIndex{0}; combinationIndex < columnCombinationsToCheck_.size(); combinationIndex++){
+			const long long int validRowCount{windowValidCounts_[combinationIndex]};
+
+			nlohmann::json resultObject;
+			resultObject["combination"] = formatCombinationForDisplay(columnCombinationsToCheck_[combinationIndex]);
+			resultObject["valid_rows"] = validRowCount;
+			resultObject["completeness"] = static_cast<float>(validRowCount) / static_cast<float>(windowRowCount);
+
+			resultsArray.push_back(std::move(resultObject));
+		}
+		windowObject["results"] = std::move(resultsArray);
+
+		return windowObject.dump();
+	}
+
+	std::string windowOutput;
+	if(outputFormat_ == OutputFormat::CSV){
+		windowOutput = fmt::format("{},{},{}", windowIndex, firstRow, lastRow);
+	}else{
+		windowOutput = fmt::format("window={} rows={}-{}", windowIndex, firstRow, lastRow);
+	}
+
+	for(std::size_t combinationIndex{0}; combinationIndex < columnCombinationsToCheck_.size(); combinationIndex++){
+		const float completeness{static_cast<float>(windowValidCounts_[combinationIndex]) / static_cast<float>(windowRowCount)};
+
+		if(outputFormat_ == OutputFormat::CSV){
+			windowOutput += fmt::format(",{:.2f}", completeness);
+		}else{
+			windowOutput += fmt::format(" {}={:.2f}",
+				formatCombinationForDisplay(columnCombinationsToCheck_[combinationIndex]),
+				completeness
+			);
+		}
+	}
+
+	return windowOutput;
+}
+
+std::string NaNalyzer::formatScanEstimate(long long int byteCount, double elapsedSeconds) const{
+	// a followed file has no end, and a shard's end is not the file's
+	if(followInterval_.has_value() || byteRange_.has_value() || scanTelemetry_.fileBytes <= 0) return {};
+	if(byteCount <= 0 || elapsedSeconds <= 0.0) return {};
+
+	const double doneShare{std::min(1.0, static_cast<double>(byteCount) / static_cast<double>(scanTelemetry_.fileBytes))};
+
+	// the rate seen so far includes the time the throttle slept, but the first blocks may still
+	// have come out of its burst allowance, which the rest of the file will not get
+	double bytesPerSecond{static_cast<double>(byteCount) / elapsedSeconds};
+	const bool isRateCapped{scanThrottle_ && scanThrottle_->maxBytesPerSecond().has_value()};
+	if(isRateCapped) bytesPerSecond = std::min(bytesPerSecond, scanThrottle_->maxBytesPerSecond().value());
+
+	const long long int secondsLeft{std::llround(static_cast<double>(std::max(0LL, scanTelemetry_.fileBytes - byteCount)) / bytesPerSecond)};
+	const std::string timeLeft{
+		secondsLeft >= 3600 ? fmt::format("{}h {:02}m", secondsLeft / 3600, secondsLeft % 3600 / 60) :
+		secondsLeft >= 60 ? fmt::format("{}m {:02}s", secondsLeft / 60, secondsLeft % 60) :
+		fmt::format("{}s", secondsLeft)
+	};
+
+	return fmt::format(" ({:.0f}%, about {} left{})", doneShare * 100.0, timeLeft, scanThrottle_ ? ", throttled" : "");
+}
+
+void NaNalyzer::printScanStatistics() const{
+	constexpr double bytesPerMebibyte{1024.0 * 1024.0};
+
+	std::fflush(stdout); // keeps the statistics after the results when both go to one terminal
+	fmt::println(stderr, "\n--- Statistics ---");
+	fmt::println(stderr, "Data rows: {}", scanTelemetry_.rowCount);
+	fmt::println(stderr, "Bytes read: {} of {}", scanTelemetry_.bytesRead, scanTelemetry_.fileBytes);
+	fmt::println(
+		stderr,
+		"Duration: {:.3f} s ({:.1f} MiB/s)",
+		scanTelemetry_.durationSeconds,
+		scanTelemetry_.durationSeconds > 0.0 ? scanTelemetry_.bytesRead / bytesPerMebibyte / scanTelemetry_.durationSeconds : 0.0
+	);
+	fmt::println(stderr, "Scanning threads: {}", scanTelemetry_.threadCount);
+	if(!scanTelemetry_.readMethod.empty()) fmt::println(stderr, "Reads: {}", scanTelemetry_.readMethod);
+	if(scanThrottle_){
+		std::string limits;
+		if(scanThrottle_->maxBytesPerSecond().has_value()){
+			limits += fmt::format("reads capped at {:.1f} MiB/s", scanThrottle_->maxBytesPerSecond().value() / bytesPerMebibyte);
+		}
+		if(scanThrottle_->cpuBudget().has_value()){
+			if(!limits.empty()) limits += ", ";
+			limits += fmt::format("CPU budget {:.0f}% of a core", scanThrottle_->cpuBudget().value() * 100.0);
+		}
+		fmt::println(stderr, "Throttled: {:.3f} s ({})", scanTelemetry_.throttledSeconds, limits);
+	}
+
+	const std::optional<long long int> peakResidentBytes{MemoryStats::peakResidentBytes()};
+	if(peakResidentBytes.has_value()){
+		fmt::println(stderr, "Peak resident memory: {:.1f} MiB", peakResidentBytes.value() / bytesPerMebibyte);
+	}else{
+		fmt::println(stderr, "Peak resident memory: not available on this platform");
+	}
+
+	if(!MemoryStats::countsAllocations){
+		fmt::println(stderr, "Heap allocations: not counted (configure with -DALLOCATION_ACCOUNTING=ON)");
+		return;
+	}
+
+	fmt::println(stderr, "Heap allocations:");
+	for(int phaseIndex{0}; phaseIndex < static_cast<int>(MemoryStats::Phase::COUNT); phaseIndex++){
+		const MemoryStats::Phase phase{static_cast<MemoryStats::Phase>(phaseIndex)};
+		const MemoryStats::AllocationCounters counters{MemoryStats::allocationCounters(phase)};
+		fmt::println(stderr, "  {}: {} allocations, {} bytes", MemoryStats::phaseName(phase), counters.allocations, counters.bytes);
+	}
+}
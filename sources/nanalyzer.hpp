@@ -6,14 +6,49 @@
 #include <unordered_map>
 #include <atomic>
 #include <chrono>
+#include <condition_variable>
+#include <mutex>
 #include <exception>
+#include <memory>
 #include <optional>
+#include <string_view>
+#include <thread>
+
+#include <nlohmann/json_fwd.hpp>
+
+#include "arena.hpp"
+#include "columnarcache.hpp"
+#include "hyperloglog.hpp"
+#include "patternmatcher.hpp"
+#include "rowfilter.hpp"
+#include "ruleexpression.hpp"
+#include "throttle.hpp"
+#include "topksketch.hpp"
+#include "typerule.hpp"
+#include "tokenizer.hpp"
 
 enum class OutputFormat{
     TEXT,
     JSON,
     CSV,
-    KEYVALUE
+    KEYVALUE,
+    OPENMETRICS
+};
+
+enum class WindowUnit{
+    ROWS,
+    BYTES
+};
+
+enum class DistinctMode{
+    EXACT,      // every distinct key interned in an arena
+    HYPERLOGLOG // fixed memory sketches, approximate counts
+};
+
+enum class EarlyExitMode{
+    NONE,
+    EXACT,      // stop once the remaining bytes can no longer change any gate's outcome
+    SEQUENTIAL  // stop once a confidence sequence puts every gate's completeness on one side of its threshold
 };
 
 struct CLIConfig{
@@ -22,11 +57,44 @@ struct CLIConfig{
     std::optional<std::string> outputFilePath;
     std::optional<std::string> fieldsInput;
     std::optional<std::string> invalidValuesInput;
+    std::vector<std::string> invalidPatternInputs; // each "field=pattern"
+    std::vector<std::string> typeRuleInputs;       // each "field=type[:min..max]"
     std::optional<std::string> combinationsInput;
+    std::vector<std::string> whereInputs;          // each "field op value", all must hold for a row to count
+    std::optional<std::string> groupByInput;
+    std::optional<std::string> distinctOnInput;
+    std::optional<std::string> distinctModeInput;
+    std::optional<std::string> windowInput;
+    std::optional<std::string> followInput;
+    std::optional<std::string> failedRowsFilePath;
+    std::optional<std::string> splitCombinationInput;
+    std::optional<std::string> delimiterInput;
+    std::optional<std::string> quoteInput;
+    bool noTrim{false};
+    std::optional<std::string> cacheFilePath;
+    std::vector<std::string> failUnderInputs; // each "combination=ratio"
+    std::optional<std::string> earlyExitInput;
+    std::optional<std::string> metricsTextfilePath;
+    std::optional<std::string> byteRangeInput;
+    std::optional<std::string> baselineFilePath;
+    std::optional<std::string> profileValuesInput; // empty for the default path next to the CSV
+    std::vector<std::string> mergeInputs; // partial result files given to the merge subcommand
+    std::optional<std::string> maxReadRateInput; // megabytes per second
+    std::optional<std::string> cpuBudgetInput;   // share of one core, as a ratio or a percentage
+    std::optional<int> niceness;
+    std::optional<std::string> ioPriorityInput;
+    bool directIo{false};
+    bool explain{false};
+    bool stats{false};
     bool silent{false};
     OutputFormat outputFormat{OutputFormat::TEXT};
 };
 
+struct TransparentStringHash{ // lets string keyed containers be probed with string_view cells
+    using is_transparent = void;
+    std::size_t operator()(std::string_view value) const noexcept{ return std::hash<std::string_view>{}(value); }
+};
+
 class NaNalyzer{
     using ColumnOffset = int;   // 0 based position in headers_ and CSV rows
     using ColumnNumber = int;   // 1 based identifier presented to users
@@ -34,24 +102,31 @@ class NaNalyzer{
     using FilePath = std::string;
     
     using HeaderList = std::vector<std::string>;
-    using InvalidValueSet = std::unordered_set<std::string>;
+    using InvalidValueSet = std::unordered_set<std::string, TransparentStringHash, std::equal_to<>>;
     
     using DelimitedStringList = std::vector<std::string>;
 
-    using ColumnDisjunction = std::vector<ColumnOffset>; // OR group
-    using ColumnCombination = std::vector<ColumnDisjunction>; // AND of OR groups
+    using ColumnDisjunction = std::vector<ColumnOffset>; // OR group of the original syntax
+    using ColumnCombination = RuleExpression;
     using CombinationList = std::vector<ColumnCombination>;
 
     using ValidCounts = std::vector<long long int>;
 
+    using GroupKey = std::string_view; // points into groupKeyArena_
+    using GroupIndex = std::unordered_map<GroupKey, std::size_t>;
+
 private:
     FilePath csvFilePath_;
+    CsvDialect dialect_;
 
     HeaderList headers_;
     struct Column{
         ColumnOffset index; // 0 based corresponding to headers_
         std::string name;
         InvalidValueSet invalidValues;
+        std::vector<std::string> invalidPatterns;
+        PatternMatcher invalidPatternMatcher; // all of invalidPatterns compiled together
+        TypeRule typeRule;
     };
     using ColumnMap = std::unordered_map<ColumnNumber, Column>;
     ColumnMap columns_;
@@ -59,44 +134,242 @@ private:
     CombinationList columnCombinationsToCheck_;
     ValidCounts validCounts_;
 
+    std::vector<RowFilter> rowFilters_; // rows failing any of them are left out of every count
+
+    struct ValueProfile{ // the most frequent values of one selected column, where unexpected placeholders show up
+        ColumnNumber fieldNumber;
+        ColumnOffset index;
+        TopKSketch sketch;
+    };
+    std::optional<FilePath> valueProfilePath_; // values are profiled while set, the suggestions are saved there
+    std::vector<ValueProfile> valueProfiles_;  // by field number
+
+    std::optional<ColumnOffset> groupByColumn_;
+    StringArena groupKeyArena_;
+    GroupIndex groupIndex_;
+    std::vector<GroupKey> groupKeys_;           // first seen order
+    std::vector<long long int> groupRowCounts_;
+    ValidCounts groupValidCounts_;              // groupKeys_.size() x columnCombinationsToCheck_.size()
+
+    std::vector<ColumnOffset> distinctOnColumns_; // entity key, rows sharing it count once
+    DistinctMode distinctMode_{DistinctMode::EXACT};
+    std::string distinctKeyBuffer_;               // composite key of the current row
+    StringArena distinctKeyArena_;
+    std::unordered_map<std::string_view, std::size_t> distinctIndex_;
+    std::vector<char> distinctSatisfied_;         // entities x combinations, set once any row of the entity satisfies
+    HyperLogLog distinctEntitySketch_;
+    std::vector<HyperLogLog> distinctValidSketches_; // one per combination, fed the keys of satisfying rows
+    long long int distinctEntityCount_{0};
+    ValidCounts distinctValidCounts_;
+
+    struct WindowConfig{
+        long long int size;
+        WindowUnit unit;
+    };
+    std::optional<WindowConfig> window_;
+    ValidCounts windowValidCounts_;
+
+    std::optional<std::chrono::milliseconds> followInterval_; // keep reading appended rows, publishing results this often
+
+    struct FailedRowRange{ // consecutive failing rows and the bytes they occupy in the CSV file
+        long long int firstRow; // 1 based data row, header excluded
+        long long int lastRow;
+        long long int firstByte;
+        long long int endByte;  // exclusive
+    };
+    using FailedRowRangeList = std::vector<FailedRowRange>;
+    std::optional<FilePath> failedRowsFilePath_;
+    std::vector<FailedRowRangeList> failedRowRanges_; // one list per combination
+
+    std::optional<std::size_t> splitCombinationIndex_; // rows are copied to valid or rejected output by this combination
+
+    std::optional<FilePath> cacheFilePath_;
+    ColumnarCache columnarCache_;
+
+    struct Prescan{ // every column read into memory in the background while the setup prompts wait for input
+        std::thread thread;
+        std::mutex mutex; // held by the scanning thread for one batch of rows at a time
+        std::condition_variable condition;
+        ColumnarCache cache;
+        std::atomic<long long int> rowCount{0};
+        std::atomic<bool> stopRequested{false};
+        bool finished{false};   // the thread has returned
+        bool reachedEnd{false}; // and read the whole file
+    };
+    std::unique_ptr<Prescan> prescan_;
+
+    struct PrescanPreview{
+        long long int rowCount{0};
+        long long int validCount{0};
+        bool complete{false}; // false while the pre-scan is still running
+        std::vector<std::pair<std::string, long long int>> frequentValues; // most frequent first
+    };
+
+    enum class GateStatus{
+        UNDECIDED,
+        PASSED,
+        FAILED
+    };
+    struct QualityGate{ // the run fails when the combination's completeness ends up below the minimum
+        std::size_t combinationIndex;
+        double minimumCompleteness;
+        GateStatus status{GateStatus::UNDECIDED};
+        long long int decidedAtRow{0};
+    };
+    std::vector<QualityGate> qualityGates_;
+    EarlyExitMode earlyExitMode_{EarlyExitMode::NONE};
+    bool stoppedEarly_{false};
+
+    struct ScanTelemetry{
+        double durationSeconds{0.0};
+        long long int bytesRead{0};
+        long long int fileBytes{0};
+        int threadCount{0};
+        long long int rowCount{0};
+        long long int dataOffset{0}; // first byte after the header
+        std::string readMethod;      // how the CSV blocks were read, empty when they came from elsewhere
+        double throttledSeconds{0.0};
+    };
+    ScanTelemetry scanTelemetry_;
+    std::optional<FilePath> metricsTextfilePath_; // rewritten atomically while the scan runs
+
+    struct ByteRange{ // the rows whose first byte lies in [begin, end), one shard of a scan spread over machines
+        long long int begin;
+        long long int end;
+    };
+    std::optional<ByteRange> byteRange_;
+
+    struct Baseline{ // the same configuration evaluated over an earlier file, scanned alongside this one
+        FilePath csvFilePath;
+        long long int totalRowCount{0};
+        ValidCounts validCounts;
+        bool fromCache{false}; // the result saved by an earlier run still matched the file
+    };
+    std::optional<FilePath> baselineFilePath_;
+    std::optional<Baseline> baseline_;
+
+    struct BaselineDelta{
+        double baselineCompleteness;
+        double completeness;
+        double zScore;     // two-proportion test of the difference, negative when completeness dropped
+        bool isRegression; // significantly and noticeably below the baseline
+    };
+
 private:
     bool configurationLoadedFromJson_{false};
+    bool dialectSetFromCli_{false};
     bool silentMode_{false};
+    bool statsEnabled_{false}; // scan statistics are printed to stderr after the results
+    bool directIo_{false};     // the CSV is read past the page cache where the file system allows it
+    std::shared_ptr<ScanThrottle> scanThrottle_; // caps reads and CPU time of every reader, shared with the baseline's
     OutputFormat outputFormat_{OutputFormat::TEXT};
 
 public:
     NaNalyzer() = default;
-    ~NaNalyzer() = default;
+    ~NaNalyzer();
 
     int run(const CLIConfig &config = CLIConfig{});
 
     void saveInitializationToJson(const FilePath &filePath) const;
     void loadInitializationFromJson(const FilePath &filePath);
 
+    void saveFailedRowsToJson(const FilePath &filePath) const;
+    void writeMetricsTextfile(const std::string &metrics) const;
+
+    void loadPartialConfiguration(const FilePath &partialFilePath);
+    void mergePartialResults(const std::vector<FilePath> &partialFilePaths);
+
 private:
     void parseCsv();
     void defineInvalidData();
     void defineColumnCombinations();
 
+    struct CompletionSignal{ // lets the worker wake the progress loop as soon as it finishes
+        std::mutex mutex;
+        std::condition_variable condition;
+        bool complete{false};
+    };
+
+    void resetResults();
     void process();
+    void explain(); // prints the evaluation plan and a runtime estimate from a sample, counting nothing
+    long long int scan(); // fills the counts, returns the number of data rows
     void processCsvRows(
         std::chrono::steady_clock::duration updateInterval,
         std::atomic<long long int> &processedRowCount,
+        std::atomic<long long int> &processedByteCount,
         long long int &totalRowCount,
-        std::atomic<bool> &processingComplete,
+        CompletionSignal &completionSignal,
         std::exception_ptr &workerException
     );
+    bool canProcessFromColumnarCache(const ColumnarCache &cache) const;
+    void processColumnarCache(long long int &totalRowCount);
+
+    void startPrescan();
+    void prescanCsvRows(const FilePath &csvFilePath, CsvDialect dialect, const std::vector<int> &columnOffsets);
+    bool awaitPrescan(); // true when the finished pre-scan can answer process() on its own
+    void stopPrescan();
+    std::optional<PrescanPreview> previewColumnValues(const Column &column) const;
+    std::optional<PrescanPreview> previewCompleteness(const ColumnCombination &combination) const;
+    void printCompletenessPreview() const;
+
+    bool decideQualityGates(long long int rowCount, long long int remainingBytes); // true once every gate is decided
+    void concludeQualityGates(long long int totalRowCount);
+    bool hasFailedQualityGate() const;
+
+    std::unique_ptr<NaNalyzer> makeBaselineAnalyzer() const;
+    bool loadCachedBaselineResult(const FilePath &resultFilePath); // false when missing or stale
+    void saveBaselineResult(const FilePath &resultFilePath, long long int totalRowCount) const;
+    static FilePath deriveBaselineResultPath(const FilePath &baselineFilePath);
+    BaselineDelta compareWithBaseline(std::size_t combinationIndex, long long int totalRowCount) const;
+    std::string formatBaselineDelta(std::size_t combinationIndex, long long int totalRowCount) const;
+
+    static FilePath deriveValueProfilePath(const FilePath &csvFilePath);
+    static bool looksLikePlaceholder(std::string_view value);
+    std::vector<std::string> suggestInvalidValues(const ValueProfile &valueProfile) const; // most frequent first
+    nlohmann::json valueProfilesToJson() const;
+    void saveValueProfiles(const FilePath &filePath) const;
+
+    void reportResults(long long int totalRowCount);
+    void printScanStatistics() const;
+    std::string formatScanEstimate(long long int byteCount, double elapsedSeconds) const; // share done and time left, for the progress line
 
 private:
     DelimitedStringList splitString(const std::string &string, const char delimiter) const;
+    DelimitedStringList splitCombinationList(const std::string &string) const; // at commas outside parentheses
 
     void clearInputBuffer() const;
 
-    bool isCellValid(const std::string &string, const InvalidValueSet &invalidValues) const;
+    FilePath deriveSplitOutputPath(const std::string &suffix) const;
 
+    bool isCellValid(std::string_view cell, const Column &column) const;
+    bool isRowSelected(const RowFieldList &rowFields) const;
+
+    std::size_t internGroupKey(std::string_view key);
+    void recordDistinctEntity(std::string_view key, const std::vector<char> &satisfiedCombinations);
+    void concludeDistinctCounts();
+
+    ColumnCombination parseCombinationString(const std::string &combinationString) const;
     std::string formatCombinationForDisplay(const ColumnCombination &combination) const;
 
+    nlohmann::json initializationToJson() const;
+    void applyDialectFromJson(const nlohmann::json &root);
+    void applyInitializationFromJson(const nlohmann::json &root, HeaderList actualHeaders);
+    HeaderList readCsvHeader(const FilePath &csvPath) const;
+    long long int loadPartialResults(const std::vector<FilePath> &partialFilePaths); // returns the merged row count
+    std::string partialConfigurationHash() const; // identifies everything a partial's counts depend on
+
     std::string formatResultsAsJson(long long int totalRowCount) const;
     std::string formatResultsAsCsv(long long int totalRowCount) const;
     std::string formatResultsAsKeyValue(long long int totalRowCount) const;
+    std::string formatResultsAsOpenMetrics(long long int totalRowCount) const;
+    std::string formatResultsAsPartialJson(long long int totalRowCount) const;
+    std::string formatProgressAsOpenMetrics(long long int rowCount, long long int byteCount, double elapsedSeconds) const;
+    std::string formatWindowResult(
+        std::size_t windowIndex,
+        long long int firstRow,
+        long long int lastRow,
+        long long int windowRowCount,
+        long long int windowByteCount
+    ) const;
 };
\ No newline at end of file
@@ -0,0 +1,422 @@
+#include "patternmatcher.hpp"
+
+#include <fmt/core.h>
+
+#include <algorithm>
+#include <bitset>
+#include <cctype>
+#include <map>
+#include <optional>
+#include <stdexcept>
+
+#include "constants.hpp"
+
+namespace{
+
+    using ByteSet = std::bitset<256>;
+
+    struct NfaState{
+        std::vector<int> epsilonTargets;
+        ByteSet bytes;          // consumed on the single labelled edge, if any
+        int byteTarget{-1};
+    };
+
+    struct Fragment{
+        int start;
+        int accept;
+    };
+
+    // Recursive descent parser that emits Thompson NFA fragments for one pattern.
+    class PatternParser{
+    public:
+        PatternParser(std::vector<NfaState> &states, std::string_view pattern)
+            : states_{states}, pattern_{pattern}
+        {
+            // (?i) applies to the whole pattern, so it may come before or after a leading '^'
+            if(pattern_.starts_with("(?i)")){
+                caseInsensitive_ = true;
+                pattern_.remove_prefix(4);
+            }else if(pattern_.starts_with("^(?i)")){
+                caseInsensitive_ = true; // skipped by parseAlternative, right after the '^'
+            }
+        }
+
+        Fragment parse(){
+            const Fragment fragment{parseAlternation(true)};
+            if(position_ != pattern_.size()) fail("unbalanced ')'");
+            return fragment;
+        }
+
+    private:
+        Fragment parseAlternation(const bool topLevel){
+            std::vector<Fragment> alternatives{parseAlternative(topLevel)};
+            while(position_ < pattern_.size() && pattern_[position_] == '|'){
+                position_++;
+                alternatives.push_back(parseAlternative(topLevel));
+            }
+
+            if(alternatives.size() == 1) return alternatives.front();
+
+            const Fragment joined{newState(), newState()};
+            for(const Fragment &alternative : alternatives){
+                states_[joined.start].epsilonTargets.push_back(alternative.start);
+                states_[alternative.accept].epsilonTargets.push_back(joined.accept);
+            }
+            return joined;
+        }
+
+        // search semantics: an unanchored side is padded with ".*"
+        Fragment parseAlternative(const bool topLevel){
+            bool anchoredStart{false};
+            if(position_ < pattern_.size() && pattern_[position_] == '^'){
+                if(!topLevel) fail("'^' is only supported at the start of a pattern");
+                anchoredStart = true;
+                position_++;
+                if(position_ == 1 && caseInsensitive_ && pattern_.substr(position_).starts_with("(?i)")) position_ += 4;
+            }
+
+            Fragment sequence{newState(), -1};
+            sequence.accept = sequence.start;
+            if(topLevel && !anchoredStart) sequence = concatenate(sequence, anyRepeated());
+
+            bool anchoredEnd{false};
+            while(position_ < pattern_.size() && pattern_[position_] != '|' && pattern_[position_] != ')'){
+                if(pattern_[position_] == '$'){
+                    if(!topLevel) fail("'$' is only supported at the end of a pattern");
+                    position_++;
+                    if(position_ < pattern_.size() && pattern_[position_] != '|') fail("'$' is only supported at the end of a pattern");
+                    anchoredEnd = true;
+                    break;
+                }
+                sequence = concatenate(sequence, parseRepetition());
+            }
+
+            if(topLevel && !anchoredEnd) sequence = concatenate(sequence, anyRepeated());
+            return sequence;
+        }
+
+        Fragment parseRepetition(){
+            const int firstAtomState{static_cast<int>(states_.size())};
+            Fragment atom{parseAtom()};
+
+            while(position_ < pattern_.size()){
+                const char quantifier{pattern_[position_]};
+                if(quantifier == '{'){
+                    atom = parseBoundedRepetition(atom, firstAtomState);
+                    continue;
+                }
+                if(quantifier != '*' && quantifier != '+' && quantifier != '?') break;
+                position_++;
+
+                atom = repeat(atom, quantifier);
+            }
+
+            return atom;
+        }
+
+        Fragment repeat(const Fragment &atom, const char quantifier){
+            const Fragment repeated{newState(), newState()};
+            states_[repeated.start].epsilonTargets.push_back(atom.start);
+            states_[atom.accept].epsilonTargets.push_back(repeated.accept);
+            if(quantifier != '+') states_[repeated.start].epsilonTargets.push_back(repeated.accept);
+            if(quantifier != '?') states_[atom.accept].epsilonTargets.push_back(atom.start);
+            return repeated;
+        }
+
+        // {m}, {m,} and {m,n}: the atom's states, which are all those from firstAtomState on, are
+        // copied once per repetition; copies past the m-th are optional, and for {m,} the last loops
+        Fragment parseBoundedRepetition(const Fragment &atom, const int firstAtomState){
+            position_++;
+            const auto parseBound{[this]() -> std::optional<int>{
+                int bound{0};
+                const std::size_t firstDigit{position_};
+                while(position_ < pattern_.size() && std::isdigit(static_cast<unsigned char>(pattern_[position_]))){
+                    bound = std::min(bound * 10 + (pattern_[position_++] - '0'), Constants::PatternMaxRepetition + 1);
+                }
+                if(position_ == firstDigit) return std::nullopt;
+                return bound;
+            }};
+
+            const std::optional<int> minimum{parseBound()};
+            if(!minimum.has_value()) fail("'{' must start a {m}, {m,} or {m,n} quantifier, escape it as '\\{' to match it");
+            std::optional<int> maximum{minimum};
+            if(position_ < pattern_.size() && pattern_[position_] == ','){
+                position_++;
+                maximum = parseBound();
+            }
+            if(position_ >= pattern_.size() || pattern_[position_] != '}') fail("missing '}' after a {m,n} quantifier");
+            position_++;
+
+            if(maximum.has_value() && maximum.value() < minimum.value()) fail("{m,n} quantifier with n below m");
+            if(std::max(minimum.value(), maximum.value_or(0)) > Constants::PatternMaxRepetition){
+                fail(fmt::format("{{m,n}} quantifiers are limited to {} repetitions", Constants::PatternMaxRepetition));
+            }
+
+            // copied before any of them is wired up, so every copy starts from the untouched atom
+            const int copyCount{maximum.value_or(std::max(minimum.value(), 1))};
+            const int lastAtomState{static_cast<int>(states_.size())};
+            std::vector<Fragment> copies{atom};
+            while(static_cast<int>(copies.size()) < copyCount) copies.push_back(copyFragment(atom, firstAtomState, lastAtomState));
+
+            Fragment sequence{newState(), -1};
+            sequence.accept = sequence.start;
+            for(int copyIndex{0}; copyIndex < copyCount; copyIndex++){
+                Fragment part{copies[copyIndex]};
+                if(!maximum.has_value() && copyIndex == copyCount - 1) part = repeat(part, minimum.value() == 0 ? '*' : '+');
+                else if(copyIndex >= minimum.value()) part = repeat(part, '?');
+                sequence = concatenate(sequence, part);
+            }
+            return sequence;
+        }
+
+        Fragment copyFragment(const Fragment &fragment, const int firstState, const int lastState){
+            const int offset{static_cast<int>(states_.size()) - firstState};
+            for(int state{firstState}; state < lastState; state++){
+                NfaState copy{states_[state]};
+                for(int &target : copy.epsilonTargets) target += offset;
+                if(copy.byteTarget >= 0) copy.byteTarget += offset;
+                states_.push_back(std::move(copy));
+            }
+            return {fragment.start + offset, fragment.accept + offset};
+        }
+
+        Fragment parseAtom(){
+            const char character{pattern_[position_++]};
+            switch(character){
+                case '(':{
+                    if(pattern_.substr(position_).starts_with("?:")) position_ += 2;
+                    else if(pattern_.substr(position_).starts_with("?")) fail("only (?:...) groups and a leading (?i) are supported");
+
+                    const Fragment group{parseAlternation(false)};
+                    if(position_ >= pattern_.size() || pattern_[position_] != ')') fail("missing ')'");
+                    position_++;
+                    return group;
+                }
+                case '[':
+                    return byteEdge(parseClass());
+                case '.':
+                    return byteEdge(ByteSet{}.set());
+                case '\\':
+                    return byteEdge(parseEscape());
+                case '*': case '+': case '?': case '{':
+                    fail("quantifier without a preceding expression");
+                case '}':
+                    fail("unmatched '}', escape it as '\\}' to match it");
+                case '^': case '$':
+                    fail("anchors are only supported at the start or end of a pattern");
+                default:{
+                    ByteSet bytes;
+                    addByte(bytes, static_cast<unsigned char>(character));
+                    return byteEdge(bytes);
+                }
+            }
+        }
+
+        ByteSet parseClass(){
+            bool negated{false};
+            if(position_ < pattern_.size() && pattern_[position_] == '^'){
+                negated = true;
+                position_++;
+            }
+
+            ByteSet bytes;
+            bool first{true};
+            while(true){
+                if(position_ >= pattern_.size()) fail("missing ']'");
+                char character{pattern_[position_++]};
+                if(character == ']' && !first) break;
+                first = false;
+
+                if(character == '\\'){
+                    const ByteSet escaped{parseEscape()};
+                    if(escaped.count() != 1){
+                        bytes |= escaped;
+                        continue;
+                    }
+                    character = static_cast<char>(findFirst(escaped));
+                }
+
+                unsigned char rangeEnd{static_cast<unsigned char>(character)};
+                if(position_ + 1 < pattern_.size() && pattern_[position_] == '-' && pattern_[position_ + 1] != ']'){
+                    rangeEnd = static_cast<unsigned char>(pattern_[position_ + 1]);
+                    position_ += 2;
+                    if(rangeEnd < static_cast<unsigned char>(character)) fail("reversed character range");
+                }
+
+                for(unsigned int byte{static_cast<unsigned char>(character)}; byte <= rangeEnd; byte++){
+                    addByte(bytes, static_cast<unsigned char>(byte));
+                }
+            }
+
+            return negated ? ~bytes : bytes;
+        }
+
+        ByteSet parseEscape(){
+            if(position_ >= pattern_.size()) fail("trailing '\\'");
+            const char character{pattern_[position_++]};
+
+            ByteSet bytes;
+            const auto addMatching{[&bytes](int (*predicate)(int)){
+                for(int byte{0}; byte < 128; byte++){
+                    if(predicate(byte)) bytes.set(byte);
+                }
+            }};
+
+            switch(character){
+                case 'd': case 'D': addMatching(std::isdigit); break;
+                case 's': case 'S': addMatching(std::isspace); break;
+                case 'w': case 'W':
+                    addMatching(std::isalnum);
+                    bytes.set('_');
+                    break;
+                case 't': bytes.set('\t'); return bytes;
+                case 'n': bytes.set('\n'); return bytes;
+                case 'r': bytes.set('\r'); return bytes;
+                default:
+                    if(std::isalnum(static_cast<unsigned char>(character))) fail(fmt::format("unsupported escape '\\{}'", character));
+                    addByte(bytes, static_cast<unsigned char>(character));
+                    return bytes;
+            }
+
+            return std::isupper(static_cast<unsigned char>(character)) ? ~bytes : bytes;
+        }
+
+        void addByte(ByteSet &bytes, const unsigned char byte) const{
+            bytes.set(byte);
+            if(caseInsensitive_){
+                bytes.set(static_cast<unsigned char>(std::tolower(byte)));
+                bytes.set(static_cast<unsigned char>(std::toupper(byte)));
+            }
+        }
+
+        static std::size_t findFirst(const ByteSet &bytes){
+            for(std::size_t byte{0}; byte < bytes.size(); byte++){
+                if(bytes.test(byte)) return byte;
+            }
+            return 0;
+        }
+
+        Fragment anyRepeated(){
+            const int loop{newState()};
+            states_[loop].bytes.set();
+            states_[loop].byteTarget = loop;
+            return {loop, loop};
+        }
+
+        Fragment byteEdge(const ByteSet &bytes){
+            const Fragment edge{newState(), newState()};
+            states_[edge.start].bytes = bytes;
+            states_[edge.start].byteTarget = edge.accept;
+            return edge;
+        }
+
+        Fragment concatenate(const Fragment &first, const Fragment &second){
+            states_[first.accept].epsilonTargets.push_back(second.start);
+            return {first.start, second.accept};
+        }
+
+        int newState(){
+            states_.emplace_back();
+            return static_cast<int>(states_.size()) - 1;
+        }
+
+        [[noreturn]] void fail(const std::string &message) const{
+            throw std::invalid_argument{fmt::format("Invalid pattern '{}': {}.", pattern_, message)};
+        }
+
+    private:
+        std::vector<NfaState> &states_;
+        std::string_view pattern_;
+        std::size_t position_{0};
+        bool caseInsensitive_{false};
+    };
+
+    std::vector<int> epsilonClosure(const std::vector<NfaState> &states, std::vector<int> stateSet){
+        std::vector<char> visited(states.size(), 0);
+        std::vector<int> pending{stateSet};
+        for(const int state : stateSet) visited[state] = 1;
+
+        while(!pending.empty()){
+            const int state{pending.back()};
+            pending.pop_back();
+
+            for(const int target : states[state].epsilonTargets){
+                if(visited[target]) continue;
+                visited[target] = 1;
+                stateSet.push_back(target);
+                pending.push_back(target);
+            }
+        }
+
+        std::sort(stateSet.begin(), stateSet.end());
+        return stateSet;
+    }
+
+} // namespace
+
+PatternMatcher::PatternMatcher(const std::vector<std::string> &patterns){
+    if(patterns.empty()) return;
+
+    std::vector<NfaState> nfa;
+    nfa.emplace_back();
+    const int nfaStart{0};
+
+    std::vector<char> isNfaAccept;
+    for(const std::string &pattern : patterns){
+        const Fragment fragment{PatternParser{nfa, pattern}.parse()};
+        nfa[nfaStart].epsilonTargets.push_back(fragment.start);
+
+        isNfaAccept.resize(nfa.size(), 0);
+        isNfaAccept[fragment.accept] = 1;
+    }
+    isNfaAccept.resize(nfa.size(), 0);
+
+    // subset construction; DFA state 0 is the dead state (empty NFA set)
+    std::map<std::vector<int>, std::uint32_t> dfaStateIds;
+    std::vector<std::vector<int>> dfaStateSets{std::vector<int>{}};
+    dfaStateIds.emplace(std::vector<int>{}, DeadState);
+
+    const std::vector<int> startSet{epsilonClosure(nfa, {nfaStart})};
+    dfaStateIds.emplace(startSet, StartState);
+    dfaStateSets.push_back(startSet);
+
+    transitions_.assign(2 * 256, DeadState);
+
+    for(std::size_t dfaState{StartState}; dfaState < dfaStateSets.size(); dfaState++){
+        for(unsigned int byte{0}; byte < 256; byte++){
+            std::vector<int> moved;
+            for(const int nfaState : dfaStateSets[dfaState]){
+                if(nfa[nfaState].byteTarget >= 0 && nfa[nfaState].bytes.test(byte)){
+                    moved.push_back(nfa[nfaState].byteTarget);
+                }
+            }
+            if(moved.empty()) continue;
+
+            std::vector<int> target{epsilonClosure(nfa, std::move(moved))};
+            auto [targetEntry, inserted]{dfaStateIds.emplace(std::move(target), static_cast<std::uint32_t>(dfaStateSets.size()))};
+            if(inserted){
+                if(dfaStateSets.size() >= Constants::PatternMaxDfaStates){
+                    throw std::invalid_argument{fmt::format(
+                        "Invalid patterns: they compile to more than {} DFA states.",
+                        Constants::PatternMaxDfaStates
+                    )};
+                }
+                dfaStateSets.push_back(targetEntry->first);
+                transitions_.resize(dfaStateSets.size() * 256, DeadState);
+            }
+
+            transitions_[dfaState * 256 + byte] = targetEntry->second;
+        }
+    }
+
+    stateKinds_.assign(dfaStateSets.size(), StateKind::REJECTS);
+    for(std::size_t dfaState{StartState}; dfaState < dfaStateSets.size(); dfaState++){
+        const std::vector<int> &stateSet{dfaStateSets[dfaState]};
+        const bool accepts{std::any_of(stateSet.begin(), stateSet.end(), [&isNfaAccept](const int state){ return isNfaAccept[state] != 0; })};
+        if(!accepts) continue;
+
+        const auto first{transitions_.begin() + static_cast<std::ptrdiff_t>(dfaState * 256)};
+        const bool loopsOnEveryByte{std::all_of(first, first + 256, [dfaState](const std::uint32_t target){ return target == dfaState; })};
+        stateKinds_[dfaState] = loopsOnEveryByte ? StateKind::ALWAYS_ACCEPTS : StateKind::ACCEPTS;
+    }
+}
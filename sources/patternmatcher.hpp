@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Matches cells against a set of regular expressions with one DFA walk per cell.
+//
+// All patterns of a column are compiled together: each is parsed into a Thompson NFA, the
+// NFAs are joined under one start state, and subset construction turns the union into a
+// single table driven DFA. A cell matches when any pattern finds a match in it, following
+// std::regex_search semantics. Supported syntax: literals, '.', [] classes with ranges and
+// negation, \d \w \s (and their negations) plus escaped punctuation, groups '(...)' and
+// '(?:...)', alternation '|', the quantifiers '*', '+', '?', {m}, {m,} and {m,n}, '^' and '$'
+// at the start or end of an alternative, and a leading (?i), before or after a leading '^',
+// for case-insensitive matching.
+class PatternMatcher{
+public:
+    PatternMatcher() = default;
+    explicit PatternMatcher(const std::vector<std::string> &patterns);
+
+    bool empty() const{ return transitions_.empty(); }
+
+    bool matches(std::string_view cell) const{
+        std::uint32_t state{StartState};
+        for(const char character : cell){
+            state = transitions_[state * 256 + static_cast<unsigned char>(character)];
+            if(state == DeadState) return false;
+            if(stateKinds_[state] == StateKind::ALWAYS_ACCEPTS) return true;
+        }
+        return stateKinds_[state] != StateKind::REJECTS;
+    }
+
+    std::size_t stateCount() const{ return stateKinds_.size(); }
+
+private:
+    enum class StateKind : std::uint8_t{
+        REJECTS,
+        ACCEPTS,
+        ALWAYS_ACCEPTS // accepting and every byte loops back, so the rest of the cell is irrelevant
+    };
+
+    static constexpr std::uint32_t DeadState{0};
+    static constexpr std::uint32_t StartState{1};
+
+    std::vector<std::uint32_t> transitions_; // stateCount x 256
+    std::vector<StateKind> stateKinds_;
+};
@@ -1,29 +1,107 @@
 #include "nanalyzer.hpp"
 
-#include <csv.h>
+#include <algorithm>
+#include <cmath>
+#include <csignal>
+#include <filesystem>
+#include <limits>
+#include <numeric>
 
 #include <fmt/core.h>
 #include <fmt/ranges.h>
 
+#include "adaptivecombination.hpp"
 #include "constants.hpp"
+#include "filewatcher.hpp"
+#include "memorystats.hpp"
+#include "rangewriter.hpp"
+#include "recordreader.hpp"
+
+namespace{
+
+	volatile std::sig_atomic_t followStopRequested{0}; // set by SIGINT / SIGTERM while following a file
+
+	void requestFollowStop(int){
+		followStopRequested = 1;
+	}
+
+	template<typename CombinationList>
+	std::vector<AdaptiveCombination> makeCombinationEvaluators(const CombinationList &combinations){
+		std::vector<AdaptiveCombination> evaluators;
+		evaluators.reserve(combinations.size());
+		for(const auto &combination : combinations) evaluators.emplace_back(combination);
+		return evaluators;
+	}
+
+} // namespace
 
 void NaNalyzer::processCsvRows(
 	std::chrono::steady_clock::duration updateInterval,
 	std::atomic<long long int> 			&processedRowCount,
+	std::atomic<long long int> 			&processedByteCount,
 	long long int 						&totalRowCount,
-	std::atomic<bool> 					&processingComplete,
+	CompletionSignal 					&completionSignal,
 	std::exception_ptr 					&workerException
 ){
 	auto lastProgressUpdate{std::chrono::steady_clock::now()};
-	long long int totalRowCountLocal{0};
+	long long int totalRowCountLocal{0}; // rows passing the filters
+	long long int dataRowNumber{0};      // every data row, numbering the failed rows by their place in the file
+
+	// a window spans data rows by their place in the file, rows rejected by --where included, but
+	// only the selected ones count towards its size and completeness
+	std::size_t windowIndex{0};
+	long long int windowFirstRow{1};
+	long long int windowRowCount{0};
+	long long int windowByteCount{0};
+
+	long long int rowByteOffset{0};
+	const auto emitWindow{[&](){
+		fmt::println("{}", formatWindowResult(windowIndex, windowFirstRow, dataRowNumber, windowRowCount, windowByteCount));
+		std::fflush(stdout);
+
+		windowIndex += 1;
+		windowFirstRow = dataRowNumber + 1;
+		windowRowCount = 0;
+		windowByteCount = 0;
+		std::fill(windowValidCounts_.begin(), windowValidCounts_.end(), 0);
+	}};
 
 	try{
-		io::LineReader csvLineReader{csvFilePath_};
+		// only the cells something looks at are kept, every other field is skipped unbuffered
+		std::vector<int> retainedColumnOffsets;
+		for(const auto &columnEntry : columns_) retainedColumnOffsets.push_back(columnEntry.second.index);
+		if(groupByColumn_.has_value()) retainedColumnOffsets.push_back(groupByColumn_.value());
+		retainedColumnOffsets.insert(retainedColumnOffsets.end(), distinctOnColumns_.begin(), distinctOnColumns_.end());
+		for(const RowFilter &rowFilter : rowFilters_) retainedColumnOffsets.push_back(rowFilter.columnOffset());
+
+		const bool followMode{followInterval_.has_value()};
+
+		std::optional<CsvRecordReader> recordReader;
+		RowFieldList headerFields;
 		try{
-			char *headerLine{csvLineReader.next_line()};
-			if(!headerLine){
+			recordReader.emplace(csvFilePath_, retainedColumnOffsets, followMode, directIo_, scanThrottle_.get());
+			scanTelemetry_.readMethod = fmt::format(
+				"{}{}",
+				recordReader->usesIoUring() ? fmt::format("io_uring, {} blocks in flight", Constants::AsyncReadQueueDepth) : "blocking",
+				recordReader->usesDirectIo() ? ", direct I/O" : ""
+			);
+			if(directIo_ && !recordReader->usesDirectIo() && !silentMode_){
+				fmt::println("Direct I/O is not available for '{}', reading it through the page cache.", csvFilePath_);
+			}
+
+			const bool hasHeader{visitRowTokenizer(dialect_, [&](const auto tokenizeRow){
+				return recordReader->readRecord(tokenizeRow, headerFields);
+			})};
+			if(!hasHeader){
 				throw std::runtime_error{"No header line found in CSV file."};
 			}
+			rowByteOffset = recordReader->bytesConsumed();
+			scanTelemetry_.dataOffset = rowByteOffset;
+
+			if(byteRange_.has_value() && byteRange_->begin > rowByteOffset){
+				recordReader->seekToRecordAt(byteRange_->begin);
+				rowByteOffset = recordReader->bytesConsumed();
+			}
 		}catch(const std::exception &exception){
 			throw std::runtime_error{fmt::format(
 				"Could not open or read file '{}'.\nDetails: {}",
@@ -32,53 +110,868 @@ void NaNalyzer::processCsvRows(
 			)};
 		}
 
-		char *currentLine{nullptr};
-		while((currentLine = csvLineReader.next_line()) != nullptr){
-			totalRowCountLocal += 1;
+		std::error_code fileSizeError;
+		const auto fileSize{std::filesystem::file_size(csvFilePath_, fileSizeError)};
+		const long long int csvFileSize{fileSizeError ? std::numeric_limits<long long int>::max() : static_cast<long long int>(fileSize)};
 
-			DelimitedStringList rowFields{splitString(std::string{currentLine}, ',')};
+		std::optional<ByteRangeWriter> validRowWriter;
+		std::optional<ByteRangeWriter> rejectedRowWriter;
+		if(splitCombinationIndex_.has_value()){
+			validRowWriter.emplace(csvFilePath_, deriveSplitOutputPath("valid"));
+			rejectedRowWriter.emplace(csvFilePath_, deriveSplitOutputPath("rejected"));
 
-			for(std::size_t combinationIndex{0}; combinationIndex < columnCombinationsToCheck_.size(); combinationIndex++){
-				const ColumnCombination &columnCombination{columnCombinationsToCheck_[combinationIndex]};
-				bool isCombinationSatisfied{true};
+			validRowWriter->append(0, rowByteOffset);
+			rejectedRowWriter->append(0, rowByteOffset);
+		}
 
-				for(const ColumnDisjunction &clause : columnCombination){
-					bool isClauseSatisfied{false};
+		const auto scanStart{std::chrono::steady_clock::now()};
+		const auto publishFollowResults{[&](){
+			if(!distinctOnColumns_.empty()) concludeDistinctCounts();
+			scanTelemetry_.bytesRead = recordReader->bytesConsumed();
+			scanTelemetry_.durationSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - scanStart).count();
 
-					for(const ColumnOffset columnOffset : clause){
-						const Column &columnDefinition{columns_.at(columnOffset + 1)};
+			if(metricsTextfilePath_.has_value()) writeMetricsTextfile(formatResultsAsOpenMetrics(totalRowCountLocal));
+
+			if(outputFormat_ == OutputFormat::JSON){
+				fmt::println("{}", formatResultsAsJson(totalRowCountLocal));
+			}else if(outputFormat_ == OutputFormat::CSV){
+				fmt::println("{}", formatResultsAsCsv(totalRowCountLocal));
+			}else if(outputFormat_ == OutputFormat::KEYVALUE){
+				fmt::println("{}", formatResultsAsKeyValue(totalRowCountLocal));
+			}else if(outputFormat_ == OutputFormat::OPENMETRICS){
+				fmt::println("{}", formatResultsAsOpenMetrics(totalRowCountLocal));
+			}else{
+				fmt::println("rows={} {}", totalRowCountLocal, formatResultsAsKeyValue(totalRowCountLocal));
+			}
+			std::fflush(stdout);
+		}};
 
-						if(columnOffset >= static_cast<int>(rowFields.size())) continue;
+		std::optional<FileWatcher> fileWatcher;
+		if(followMode){
+			fileWatcher.emplace(csvFilePath_);
 
-						if(isCellValid(rowFields[columnOffset], columnDefinition.invalidValues)){
-							isClauseSatisfied = true;
-							break;
+			followStopRequested = 0;
+			std::signal(SIGINT, requestFollowStop);
+			std::signal(SIGTERM, requestFollowStop);
+		}
+
+		// resolve the dialect once so the row loop below is compiled against a fixed tokenizer
+		visitRowTokenizer(dialect_, [&](const auto tokenizeRow){
+			RowFieldList rowFields;
+			std::vector<char> satisfiedCombinations(columnCombinationsToCheck_.size(), 0);
+			std::vector<AdaptiveCombination> combinationEvaluators{makeCombinationEvaluators(columnCombinationsToCheck_)};
+
+			auto nextFollowPublish{std::chrono::steady_clock::now() + followInterval_.value_or(std::chrono::milliseconds{0})};
+			bool hasHeader{true};
+			bool hasDrainedReplacedFile{false};
+
+			MemoryStats::enterPhase(MemoryStats::Phase::WARM_UP);
+
+			while(true){
+				while(hasHeader && recordReader->readRecord(tokenizeRow, rowFields)){
+					// a shard ends before the first row starting past it, which belongs to the next shard
+					if(byteRange_.has_value() && recordReader->recordOffset() >= byteRange_->end) break;
+
+					dataRowNumber += 1;
+					if(dataRowNumber == Constants::AllocationWarmUpRowCount + 1) MemoryStats::enterPhase(MemoryStats::Phase::DATA_ROWS);
+					const long long int rowByteLength{recordReader->recordLength()};
+
+					if(columnarCache_.isBuilding()) columnarCache_.appendRow(rowFields);
+
+					if(!rowFilters_.empty() && !isRowSelected(rowFields)){
+						// not part of the analyzed rows, so never valid for a split either
+						if(splitCombinationIndex_.has_value()) rejectedRowWriter->append(rowByteOffset, rowByteOffset + rowByteLength);
+						windowByteCount += rowByteLength;
+						rowByteOffset += rowByteLength;
+						continue;
+					}
+					totalRowCountLocal += 1;
+
+					for(ValueProfile &valueProfile : valueProfiles_){
+						valueProfile.sketch.add(valueProfile.index < static_cast<int>(rowFields.size()) ? rowFields[valueProfile.index] : std::string_view{});
+					}
+
+					long long int *groupValidCounts{nullptr};
+					if(groupByColumn_.has_value()){
+						const ColumnOffset groupOffset{groupByColumn_.value()};
+						const std::size_t groupIndex{internGroupKey(
+							groupOffset < static_cast<int>(rowFields.size()) ? rowFields[groupOffset] : std::string_view{}
+						)};
+						groupRowCounts_[groupIndex] += 1;
+						groupValidCounts = &groupValidCounts_[groupIndex * columnCombinationsToCheck_.size()];
+					}
+
+					for(std::size_t combinationIndex{0}; combinationIndex < columnCombinationsToCheck_.size(); combinationIndex++){
+						const bool isCombinationSatisfied{combinationEvaluators[combinationIndex].evaluate(
+							[this, &rowFields](const ColumnOffset columnOffset){
+								if(columnOffset >= static_cast<int>(rowFields.size())) return false;
+								return isCellValid(rowFields[columnOffset], columns_.at(columnOffset + 1));
+							}
+						)};
+						satisfiedCombinations[combinationIndex] = isCombinationSatisfied;
+
+						if(splitCombinationIndex_ == combinationIndex){
+							ByteRangeWriter &rowWriter{isCombinationSatisfied ? validRowWriter.value() : rejectedRowWriter.value()};
+							rowWriter.append(rowByteOffset, rowByteOffset + rowByteLength);
+						}
+
+						if(isCombinationSatisfied){
+							validCounts_[combinationIndex] += 1;
+							if(groupValidCounts) groupValidCounts[combinationIndex] += 1;
+							if(window_.has_value()) windowValidCounts_[combinationIndex] += 1;
+						}else if(failedRowsFilePath_.has_value()){
+							FailedRowRangeList &failedRanges{failedRowRanges_[combinationIndex]};
+							if(!failedRanges.empty() && failedRanges.back().lastRow == dataRowNumber - 1){
+								failedRanges.back().lastRow = dataRowNumber;
+								failedRanges.back().endByte = rowByteOffset + rowByteLength;
+							}else{
+								failedRanges.push_back({dataRowNumber, dataRowNumber, rowByteOffset, rowByteOffset + rowByteLength});
+							}
 						}
 					}
 
-					if(!isClauseSatisfied){
-						isCombinationSatisfied = false;
+					if(!distinctOnColumns_.empty()){
+						distinctKeyBuffer_.clear();
+						for(const ColumnOffset columnOffset : distinctOnColumns_){
+							if(columnOffset < static_cast<int>(rowFields.size())) distinctKeyBuffer_ += rowFields[columnOffset];
+							distinctKeyBuffer_ += Constants::DistinctKeySeparator;
+						}
+						recordDistinctEntity(distinctKeyBuffer_, satisfiedCombinations);
+					}
+
+					if(window_.has_value()){
+						windowRowCount += 1;
+						windowByteCount += rowByteLength;
+
+						const long long int windowProgress{window_->unit == WindowUnit::ROWS ? windowRowCount : windowByteCount};
+						if(windowProgress >= window_->size) emitWindow();
+					}
+
+					rowByteOffset += rowByteLength;
+
+					const auto now{std::chrono::steady_clock::now()};
+					if(now - lastProgressUpdate >= updateInterval){
+						processedRowCount.store(totalRowCountLocal, std::memory_order_relaxed);
+						processedByteCount.store(recordReader->bytesConsumed(), std::memory_order_relaxed);
+						lastProgressUpdate = now;
+					}
+
+					if(followMode){
+						if(followStopRequested) break;
+						if(now >= nextFollowPublish){
+							publishFollowResults();
+							nextFollowPublish = now + followInterval_.value();
+						}
+					}
+
+					if(
+						earlyExitMode_ != EarlyExitMode::NONE
+						&& totalRowCountLocal % Constants::QualityGateCheckInterval == 0
+						&& decideQualityGates(totalRowCountLocal, std::max(csvFileSize - recordReader->bytesConsumed(), 0LL))
+					){
+						stoppedEarly_ = true;
 						break;
 					}
 				}
 
-				if(isCombinationSatisfied) validCounts_[combinationIndex] += 1;
-			}
+				if(!followMode || followStopRequested) break;
+
+				const auto now{std::chrono::steady_clock::now()};
+				if(now >= nextFollowPublish){
+					publishFollowResults();
+					nextFollowPublish = now + followInterval_.value();
+				}
+
+				// rotated (the path names another file) or truncated: the complete rows read so far stay
+				// counted and the file now at the path is followed from its header on. A replaced file is
+				// read to its end once more first, for rows appended right before it was renamed; what
+				// was truncated is gone anyway.
+				std::error_code fileStatusError;
+				const bool fileExists{std::filesystem::exists(csvFilePath_, fileStatusError)};
+				const std::uintmax_t currentFileSize{fileExists ? std::filesystem::file_size(csvFilePath_, fileStatusError) : 0};
+				const bool wasTruncated{!fileStatusError && fileExists && static_cast<long long int>(currentFileSize) < recordReader->bytesConsumed()};
+				const bool wasReplaced{fileExists && fileWatcher->wasReplaced()};
+				if(wasReplaced && !hasDrainedReplacedFile){
+					hasDrainedReplacedFile = true;
+					continue;
+				}
+				if(fileExists && (wasReplaced || wasTruncated)){
+					hasDrainedReplacedFile = false;
+					fileWatcher->rearm();
+					recordReader.emplace(csvFilePath_, retainedColumnOffsets, true, directIo_, scanThrottle_.get());
+					hasHeader = false;
+				}
+
+				if(!hasHeader){
+					hasHeader = recordReader->readFullRecord(tokenizeRow, headerFields);
+					if(hasHeader){
+						if(!std::equal(headerFields.begin(), headerFields.end(), headers_.begin(), headers_.end())){
+							throw std::runtime_error{fmt::format("The file now at '{}' does not have the same headers as the one followed before.", csvFilePath_)};
+						}
+						continue;
+					}
+				}
 
-			const auto now{std::chrono::steady_clock::now()};
-			if(now - lastProgressUpdate >= updateInterval){
-				processedRowCount.store(totalRowCountLocal, std::memory_order_relaxed);
-				lastProgressUpdate = now;
+				fileWatcher->waitForChange(std::chrono::duration_cast<std::chrono::milliseconds>(nextFollowPublish - now));
 			}
+		});
+
+		if(followMode){
+			std::signal(SIGINT, SIG_DFL);
+			std::signal(SIGTERM, SIG_DFL);
+		}
+
+		if(window_.has_value() && windowRowCount > 0) emitWindow();
+
+		if(splitCombinationIndex_.has_value()){
+			validRowWriter->finish();
+			rejectedRowWriter->finish();
 		}
 
 		processedRowCount.store(totalRowCountLocal, std::memory_order_relaxed);
+		processedByteCount.store(recordReader->bytesConsumed(), std::memory_order_relaxed);
 		totalRowCount = totalRowCountLocal;
 	}catch(...){
 		workerException = std::current_exception();
 	}
 
-	processingComplete.store(true, std::memory_order_release);
+	{
+		const std::lock_guard completionLock{completionSignal.mutex};
+		completionSignal.complete = true;
+	}
+	completionSignal.condition.notify_one();
+}
+
+bool NaNalyzer::canProcessFromColumnarCache(const ColumnarCache &cache) const{
+	// split, failed row export and windows need the raw rows and their byte offsets
+	if(splitCombinationIndex_.has_value() || failedRowsFilePath_.has_value() || window_.has_value()) return false;
+
+	for(const ColumnCombination &combination : columnCombinationsToCheck_){
+		for(const ColumnOffset columnOffset : combination.columnOffsets()){
+			if(cache.columnSlot(columnOffset) < 0) return false;
+		}
+	}
+
+	for(const ColumnOffset columnOffset : distinctOnColumns_){
+		if(cache.columnSlot(columnOffset) < 0) return false;
+	}
+
+	for(const RowFilter &rowFilter : rowFilters_){
+		if(cache.columnSlot(rowFilter.columnOffset()) < 0) return false;
+	}
+
+	for(const ValueProfile &valueProfile : valueProfiles_){
+		if(cache.columnSlot(valueProfile.index) < 0) return false;
+	}
+
+	return !groupByColumn_.has_value() || cache.columnSlot(groupByColumn_.value()) >= 0;
+}
+
+void NaNalyzer::processColumnarCache(long long int &totalRowCount){
+	// classify every distinct value once, after which each cell is a single table lookup
+	std::vector<std::vector<char>> entryValidityByOffset(headers_.size());
+	std::vector<int> slotByOffset(headers_.size(), -1);
+	for(const auto &[fieldNumber, columnDefinition] : columns_){
+		const int columnSlot{columnarCache_.columnSlot(columnDefinition.index)};
+		if(columnSlot < 0) continue;
+
+		slotByOffset[columnDefinition.index] = columnSlot;
+		std::vector<char> &entryValidity{entryValidityByOffset[columnDefinition.index]};
+		for(const std::string_view entry : columnarCache_.dictionary(columnSlot)){
+			entryValidity.push_back(isCellValid(entry, columnDefinition));
+		}
+	}
+
+	const int groupSlot{groupByColumn_.has_value() ? columnarCache_.columnSlot(groupByColumn_.value()) : -1};
+	constexpr std::size_t unassignedGroup{std::numeric_limits<std::size_t>::max()};
+	std::vector<std::size_t> groupIndexByCode;
+	if(groupSlot >= 0) groupIndexByCode.assign(columnarCache_.dictionary(groupSlot).size(), unassignedGroup);
+
+	// filters are decided per dictionary entry the same way
+	std::vector<std::pair<int, std::vector<char>>> filterSlotsAndAcceptance;
+	for(const RowFilter &rowFilter : rowFilters_){
+		const int columnSlot{columnarCache_.columnSlot(rowFilter.columnOffset())};
+		std::vector<char> entryAcceptance;
+		for(const std::string_view entry : columnarCache_.dictionary(columnSlot)){
+			entryAcceptance.push_back(rowFilter.accepts(entry));
+		}
+		filterSlotsAndAcceptance.emplace_back(columnSlot, std::move(entryAcceptance));
+	}
+
+	// profiles are fed each distinct value once, weighted by how many selected rows hold it
+	std::vector<std::vector<long long int>> profileEntryCounts;
+	for(const ValueProfile &valueProfile : valueProfiles_){
+		profileEntryCounts.emplace_back(columnarCache_.dictionary(slotByOffset[valueProfile.index]).size(), 0);
+	}
+
+	std::vector<char> satisfiedCombinations(columnCombinationsToCheck_.size(), 0);
+	std::vector<AdaptiveCombination> combinationEvaluators{makeCombinationEvaluators(columnCombinationsToCheck_)};
+
+	long long int selectedRowCount{0};
+	const long long int rowCount{columnarCache_.rowCount()};
+	for(long long int row{0}; row < rowCount; row++){
+		const bool isRowSelected{std::all_of(filterSlotsAndAcceptance.begin(), filterSlotsAndAcceptance.end(), [&](const auto &filter){
+			return filter.second[columnarCache_.code(filter.first, row)] != 0;
+		})};
+		if(!isRowSelected) continue;
+		selectedRowCount += 1;
+
+		for(std::size_t profileIndex{0}; profileIndex < valueProfiles_.size(); profileIndex++){
+			profileEntryCounts[profileIndex][columnarCache_.code(slotByOffset[valueProfiles_[profileIndex].index], row)] += 1;
+		}
+
+		long long int *groupValidCounts{nullptr};
+		if(groupSlot >= 0){
+			std::size_t &groupIndex{groupIndexByCode[columnarCache_.code(groupSlot, row)]};
+			if(groupIndex == unassignedGroup){
+				groupIndex = internGroupKey(columnarCache_.dictionary(groupSlot)[columnarCache_.code(groupSlot, row)]);
+			}
+			groupRowCounts_[groupIndex] += 1;
+			groupValidCounts = &groupValidCounts_[groupIndex * columnCombinationsToCheck_.size()];
+		}
+
+		for(std::size_t combinationIndex{0}; combinationIndex < columnCombinationsToCheck_.size(); combinationIndex++){
+			const bool isCombinationSatisfied{combinationEvaluators[combinationIndex].evaluate(
+				[&](const ColumnOffset columnOffset){
+					return entryValidityByOffset[columnOffset][columnarCache_.code(slotByOffset[columnOffset], row)] != 0;
+				}
+			)};
+			satisfiedCombinations[combinationIndex] = isCombinationSatisfied;
+
+			if(isCombinationSatisfied){
+				validCounts_[combinationIndex] += 1;
+				if(groupValidCounts) groupValidCounts[combinationIndex] += 1;
+			}
+		}
+
+		if(!distinctOnColumns_.empty()){
+			distinctKeyBuffer_.clear();
+			for(const ColumnOffset columnOffset : distinctOnColumns_){
+				const int columnSlot{columnarCache_.columnSlot(columnOffset)};
+				distinctKeyBuffer_ += columnarCache_.dictionary(columnSlot)[columnarCache_.code(columnSlot, row)];
+				distinctKeyBuffer_ += Constants::DistinctKeySeparator;
+			}
+			recordDistinctEntity(distinctKeyBuffer_, satisfiedCombinations);
+		}
+	}
+
+	for(std::size_t profileIndex{0}; profileIndex < valueProfiles_.size(); profileIndex++){
+		const std::vector<std::string_view> &dictionary{columnarCache_.dictionary(slotByOffset[valueProfiles_[profileIndex].index])};
+		for(std::size_t entryIndex{0}; entryIndex < dictionary.size(); entryIndex++){
+			const long long int entryCount{profileEntryCounts[profileIndex][entryIndex]};
+			if(entryCount > 0) valueProfiles_[profileIndex].sketch.add(dictionary[entryIndex], entryCount);
+		}
+	}
+
+	totalRowCount = selectedRowCount;
+}
+
+void NaNalyzer::explain(){
+	std::vector<ColumnOffset> combinationOffsets;
+	for(const ColumnCombination &combination : columnCombinationsToCheck_){
+		const std::vector<ColumnOffset> columnOffsets{combination.columnOffsets()};
+		combinationOffsets.insert(combinationOffsets.end(), columnOffsets.begin(), columnOffsets.end());
+	}
+	std::sort(combinationOffsets.begin(), combinationOffsets.end());
+	combinationOffsets.erase(std::unique(combinationOffsets.begin(), combinationOffsets.end()), combinationOffsets.end());
+
+	std::vector<ColumnOffset> sampledOffsets{combinationOffsets};
+	for(const RowFilter &rowFilter : rowFilters_) sampledOffsets.push_back(rowFilter.columnOffset());
+	std::sort(sampledOffsets.begin(), sampledOffsets.end());
+	sampledOffsets.erase(std::unique(sampledOffsets.begin(), sampledOffsets.end()), sampledOffsets.end());
+
+	// the sampled rows keep only the cells the plan looks at, row after row in one flat list
+	std::vector<int> slotByOffset(sampledOffsets.empty() ? 0 : sampledOffsets.back() + 1, -1);
+	for(std::size_t slot{0}; slot < sampledOffsets.size(); slot++) slotByOffset[sampledOffsets[slot]] = static_cast<int>(slot);
+
+	// each measurement is repeated and its fastest round kept, the others mostly saw interruptions
+	const auto timeFastestRound{[](const auto &evaluateSample){
+		double fastestSeconds{std::numeric_limits<double>::max()};
+		for(int round{0}; round < Constants::ExplainTimingRounds; round++){
+			const auto roundStart{std::chrono::steady_clock::now()};
+			evaluateSample();
+			fastestSeconds = std::min(fastestSeconds, std::chrono::duration<double>(std::chrono::steady_clock::now() - roundStart).count());
+		}
+		return fastestSeconds;
+	}};
+
+	StringArena sampleArena;
+	std::vector<std::string_view> sampleCells;
+	long long int sampleRowCount{0};
+	long long int sampleBytes{0};
+	long long int dataOffset{0};
+	bool sampledWholeFile{false};
+	double readSeconds{0.0};
+
+	try{
+		visitRowTokenizer(dialect_, [&](const auto tokenizeRow){
+			// not throttled: the sample measures how fast the scan could go
+			CsvRecordReader recordReader{csvFilePath_, sampledOffsets, false, directIo_};
+			RowFieldList rowFields;
+
+			if(!recordReader.readRecord(tokenizeRow, rowFields)){
+				throw std::runtime_error{"No header line found in CSV file."};
+			}
+			dataOffset = recordReader.bytesConsumed();
+
+			while(recordReader.bytesConsumed() - dataOffset < static_cast<long long int>(Constants::ExplainSampleBytes)){
+				if(!recordReader.readRecord(tokenizeRow, rowFields)){
+					sampledWholeFile = true;
+					break;
+				}
+				for(const ColumnOffset columnOffset : sampledOffsets){
+					sampleCells.push_back(columnOffset < static_cast<int>(rowFields.size()) ? sampleArena.store(rowFields[columnOffset]) : std::string_view{});
+				}
+				sampleRowCount += 1;
+			}
+			sampleBytes = recordReader.bytesConsumed() - dataOffset;
+
+			// timed on a second reading, which finds the sample in the page cache like most of a warm
+			// scan does; the first one paid for the disk and for keeping the cells
+			readSeconds = timeFastestRound([&](){
+				recordReader.seekToRecordAt(dataOffset);
+				for(long long int row{0}; row < sampleRowCount && recordReader.readRecord(tokenizeRow, rowFields); row++){}
+			});
+		});
+	}catch(const std::exception &exception){
+		throw std::runtime_error{fmt::format(
+			"Could not open or read file '{}'.\nDetails: {}",
+			csvFilePath_,
+			exception.what()
+		)};
+	}
+
+	const auto sampledCell{[&](long long int sampleRow, ColumnOffset columnOffset){
+		return sampleCells[static_cast<std::size_t>(sampleRow) * sampledOffsets.size() + static_cast<std::size_t>(slotByOffset[columnOffset])];
+	}};
+
+	std::vector<long long int> selectedRows;
+	const double filterSeconds{rowFilters_.empty() ? 0.0 : timeFastestRound([&](){
+		selectedRows.clear();
+		for(long long int sampleRow{0}; sampleRow < sampleRowCount; sampleRow++){
+			const bool isSelected{std::all_of(rowFilters_.begin(), rowFilters_.end(), [&](const RowFilter &rowFilter){
+				return rowFilter.accepts(sampledCell(sampleRow, rowFilter.columnOffset()));
+			})};
+			if(isSelected) selectedRows.push_back(sampleRow);
+		}
+	})};
+	if(rowFilters_.empty()){
+		selectedRows.resize(static_cast<std::size_t>(sampleRowCount));
+		std::iota(selectedRows.begin(), selectedRows.end(), 0LL);
+	}
+
+	std::vector<double> combinationSeconds;
+	std::vector<long long int> sampleValidCounts;
+	std::vector<AdaptiveCombination> combinationEvaluators{makeCombinationEvaluators(columnCombinationsToCheck_)};
+	for(AdaptiveCombination &combinationEvaluator : combinationEvaluators){
+		long long int validRowCount{0};
+		combinationSeconds.push_back(timeFastestRound([&](){
+			validRowCount = 0;
+			for(const long long int sampleRow : selectedRows){
+				validRowCount += combinationEvaluator.evaluate([&](const ColumnOffset columnOffset){
+					return isCellValid(sampledCell(sampleRow, columnOffset), columns_.at(columnOffset + 1));
+				});
+			}
+		}));
+		sampleValidCounts.push_back(validRowCount);
+	}
+
+	const double nanosecondsPerSecond{1e9};
+	const double sampleRows{static_cast<double>(std::max(1LL, sampleRowCount))};
+	const double combinationsTotalSeconds{std::accumulate(combinationSeconds.begin(), combinationSeconds.end(), 0.0)};
+	const double sampleSeconds{readSeconds + filterSeconds + combinationsTotalSeconds};
+
+	fmt::println("\n--- Evaluation plan ---");
+	fmt::println(
+		"Each row: {}{} combination(s), each a compiled jump program that stops as soon as its outcome is known. Every {} rows, the operands of each AND likely to fail and of each OR likely to hold move to the front.",
+		rowFilters_.empty() ? "" : fmt::format("{} row filter(s), then ", rowFilters_.size()),
+		columnCombinationsToCheck_.size(),
+		Constants::ClauseReorderInterval
+	);
+	for(const RowFilter &rowFilter : rowFilters_){
+		fmt::println("Filter: {} (field {})", rowFilter.specification(), rowFilter.columnOffset() + 1);
+	}
+
+	fmt::println("\nCombinations (normalized, with their share of the evaluation cost):");
+	for(std::size_t combinationIndex{0}; combinationIndex < columnCombinationsToCheck_.size(); combinationIndex++){
+		const ColumnCombination &combination{columnCombinationsToCheck_[combinationIndex]};
+
+		std::string sampleDetails;
+		const ColumnCombination sampleOrder{combinationEvaluators[combinationIndex].order()};
+		if(sampleOrder != combination) sampleDetails = fmt::format(", checked as [{}] after the sample", formatCombinationForDisplay(sampleOrder));
+		if(!selectedRows.empty()){
+			sampleDetails += fmt::format(
+				", {:.0f} ns per row ({:.1f}%), {:.2f}% valid in the sample",
+				combinationSeconds[combinationIndex] * nanosecondsPerSecond / sampleRows,
+				combinationsTotalSeconds > 0.0 ? combinationSeconds[combinationIndex] / combinationsTotalSeconds * 100.0 : 0.0,
+				static_cast<double>(sampleValidCounts[combinationIndex]) / static_cast<double>(selectedRows.size()) * 100.0
+			);
+		}
+		fmt::println(
+			"  #{} [{}]: {} field reference(s), {} instruction(s){}",
+			combinationIndex + 1,
+			formatCombinationForDisplay(combination),
+			combination.fieldReferenceCount(),
+			combinationEvaluators[combinationIndex].instructionCount(),
+			sampleDetails
+		);
+	}
+
+	fmt::println("\nColumn offsets read: {} ({} of {} fields, the others are skipped unparsed)", fmt::join(sampledOffsets, ", "), sampledOffsets.size(), headers_.size());
+
+	fmt::println("Field checks, in the order they run:");
+	for(const ColumnOffset columnOffset : combinationOffsets){
+		const Column &column{columns_.at(columnOffset + 1)};
+
+		std::vector<std::string> checks{"empty"};
+		if(!column.invalidValues.empty()) checks.push_back(fmt::format("hash set of {} invalid value(s)", column.invalidValues.size()));
+		if(!column.typeRule.empty()) checks.push_back(fmt::format("type rule {}", column.typeRule.specification()));
+		if(!column.invalidPatternMatcher.empty()){
+			checks.push_back(fmt::format("DFA of {} states for {} pattern(s)", column.invalidPatternMatcher.stateCount(), column.invalidPatterns.size()));
+		}
+		fmt::println("  [{}] {}: {}", columnOffset + 1, column.name, fmt::join(checks, ", then "));
+	}
+
+	std::vector<std::string> unestimatedWork;
+	if(groupByColumn_.has_value()) unestimatedWork.push_back("--group-by");
+	if(!distinctOnColumns_.empty()) unestimatedWork.push_back("--distinct-on");
+	if(valueProfilePath_.has_value()) unestimatedWork.push_back("--profile-values");
+	if(failedRowsFilePath_.has_value()) unestimatedWork.push_back("--failed-rows");
+	if(splitCombinationIndex_.has_value()) unestimatedWork.push_back("--split");
+	if(window_.has_value()) unestimatedWork.push_back("--window");
+	if(cacheFilePath_.has_value()) unestimatedWork.push_back("--cache");
+	if(baselineFilePath_.has_value()) unestimatedWork.push_back("--baseline");
+
+	fmt::println("\n--- Cost estimate ---");
+	if(sampleRowCount == 0){
+		fmt::println("The file has no data rows to sample.");
+		return;
+	}
+
+	constexpr double bytesPerMebibyte{1024.0 * 1024.0};
+	fmt::println(
+		"Sample: {} ({:.1f} MiB), {} data rows{}",
+		sampledWholeFile ? "the whole file" : "the first rows",
+		static_cast<double>(sampleBytes) / bytesPerMebibyte,
+		sampleRowCount,
+		rowFilters_.empty() ? "" : fmt::format(", {} of them selected by the filters", selectedRows.size())
+	);
+	fmt::println(
+		"Per row: {:.0f} ns (reading and tokenizing {:.0f} ns, row filters {:.0f} ns, combinations {:.0f} ns)",
+		sampleSeconds * nanosecondsPerSecond / sampleRows,
+		readSeconds * nanosecondsPerSecond / sampleRows,
+		filterSeconds * nanosecondsPerSecond / sampleRows,
+		combinationsTotalSeconds * nanosecondsPerSecond / sampleRows
+	);
+
+	std::error_code fileSizeError;
+	const auto fileSize{std::filesystem::file_size(csvFilePath_, fileSizeError)};
+	if(fileSizeError || sampleBytes <= 0){
+		fmt::println("Projected: unknown, the file size could not be read.");
+		return;
+	}
+
+	// rows are assumed to be as long further into the file as they are in the sample
+	const double dataBytes{static_cast<double>(static_cast<long long int>(fileSize) - dataOffset)};
+	const double projectedRowCount{sampledWholeFile ? sampleRows : sampleRows * dataBytes / static_cast<double>(sampleBytes)};
+	double projectedSeconds{sampleSeconds / sampleRows * projectedRowCount};
+
+	std::string limitNote;
+	if(scanThrottle_){
+		if(scanThrottle_->cpuBudget().has_value() && scanThrottle_->cpuBudget().value() < 1.0){
+			projectedSeconds /= scanThrottle_->cpuBudget().value();
+			limitNote = ", at the CPU budget";
+		}
+		if(scanThrottle_->maxBytesPerSecond().has_value() && dataBytes / scanThrottle_->maxBytesPerSecond().value() > projectedSeconds){
+			projectedSeconds = dataBytes / scanThrottle_->maxBytesPerSecond().value();
+			limitNote = ", at the maximum read rate";
+		}
+	}
+
+	fmt::println(
+		"Projected: {}{:.0f} rows in about {:.2f} s for {:.1f} MiB{}",
+		sampledWholeFile ? "" : "about ",
+		projectedRowCount,
+		projectedSeconds,
+		dataBytes / bytesPerMebibyte,
+		limitNote
+	);
+	if(!unestimatedWork.empty()){
+		fmt::println("Not included: the per row work of {}.", fmt::join(unestimatedWork, ", "));
+	}
+}
+
+void NaNalyzer::startPrescan(){
+	// the cache holds every column, so large files are left to the focused scan in process()
+	std::error_code fileSizeError;
+	const auto csvFileSize{std::filesystem::file_size(csvFilePath_, fileSizeError)};
+	if(fileSizeError || csvFileSize > Constants::PrescanMaxFileSize) return;
+
+	std::vector<int> columnOffsets(headers_.size());
+	std::iota(columnOffsets.begin(), columnOffsets.end(), 0);
+
+	prescan_ = std::make_unique<Prescan>();
+	prescan_->cache.reset(
+		ColumnarCache::stampFile(csvFilePath_, dialect_),
+		columnOffsets,
+		ColumnarCache::DictionaryOverflow::DROP_COLUMN // an identifier column must not cost the previews of all others
+	);
+	prescan_->thread = std::thread{&NaNalyzer::prescanCsvRows, this, csvFilePath_, dialect_, std::move(columnOffsets)};
+}
+
+void NaNalyzer::prescanCsvRows(const FilePath &csvFilePath, const CsvDialect dialect, const std::vector<int> &columnOffsets){
+	Prescan &prescan{*prescan_};
+	bool reachedEnd{false};
+
+	try{
+		CsvRecordReader recordReader{csvFilePath, columnOffsets, false, false, scanThrottle_.get()};
+		RowFieldList rowFields;
+
+		visitRowTokenizer(dialect, [&](const auto tokenizeRow){
+			if(!recordReader.readRecord(tokenizeRow, rowFields)) return; // not even a header
+
+			while(!reachedEnd && !prescan.stopRequested.load(std::memory_order_relaxed)){
+				const std::lock_guard batchLock{prescan.mutex};
+				for(long long int batchRow{0}; batchRow < Constants::PrescanBatchRowCount; batchRow++){
+					if(!recordReader.readRecord(tokenizeRow, rowFields)){
+						reachedEnd = true;
+						break;
+					}
+					prescan.cache.appendRow(rowFields);
+				}
+				prescan.rowCount.store(prescan.cache.rowCount(), std::memory_order_relaxed);
+			}
+		});
+	}catch(const std::exception &){
+		// nothing to report in the middle of a prompt, the session just goes without previews
+		reachedEnd = false;
+	}
+
+	{
+		const std::lock_guard finishLock{prescan.mutex};
+		prescan.finished = true;
+		prescan.reachedEnd = reachedEnd;
+	}
+	prescan.condition.notify_all();
+}
+
+bool NaNalyzer::awaitPrescan(){
+	if(!prescan_) return false;
+	Prescan &prescan{*prescan_};
+
+	std::unique_lock prescanLock{prescan.mutex};
+	// waiting only pays off when the cache will be able to answer; a follow scan never ends anyway and a shard wants its own rows only
+	if(followInterval_.has_value() || byteRange_.has_value() || !canProcessFromColumnarCache(prescan.cache)) return false;
+
+	std::size_t maxProgressMessageWidth{0};
+	while(!prescan.condition.wait_for(
+		prescanLock,
+		Constants::ProgressUpdateInterval,
+		[&prescan](){ return prescan.finished; }
+	)){
+		if(silentMode_) continue;
+
+		const std::string progressMessage{fmt::format("Pre-scanned {} rows...", prescan.rowCount.load(std::memory_order_relaxed))};
+		maxProgressMessageWidth = std::max(maxProgressMessageWidth, progressMessage.size());
+		fmt::print("\r{:<{}}", progressMessage, maxProgressMessageWidth);
+		std::fflush(stdout);
+	}
+	if(maxProgressMessageWidth > 0) fmt::print("\n");
+
+	// a column can still have outgrown its dictionary, or the file been edited while the prompts were open
+	if(!prescan.reachedEnd || !canProcessFromColumnarCache(prescan.cache)) return false;
+
+	try{
+		return prescan.cache.stamp() == ColumnarCache::stampFile(csvFilePath_, dialect_);
+	}catch(const std::filesystem::filesystem_error &){
+		return false;
+	}
+}
+
+void NaNalyzer::stopPrescan(){
+	if(!prescan_) return;
+
+	prescan_->stopRequested.store(true, std::memory_order_relaxed);
+	if(prescan_->thread.joinable()) prescan_->thread.join();
+	prescan_.reset();
+}
+
+std::optional<NaNalyzer::PrescanPreview> NaNalyzer::previewColumnValues(const Column &column) const{
+	if(!prescan_) return std::nullopt;
+
+	const std::lock_guard prescanLock{prescan_->mutex};
+	const ColumnarCache &cache{prescan_->cache};
+	const int columnSlot{cache.columnSlot(column.index)};
+	if(columnSlot < 0) return std::nullopt;
+
+	// once the codes are counted, validity and frequency only need to look at each distinct value
+	const std::vector<std::string_view> &dictionary{cache.dictionary(columnSlot)};
+	std::vector<long long int> entryCounts(dictionary.size(), 0);
+	for(long long int row{0}; row < cache.rowCount(); row++){
+		entryCounts[cache.code(columnSlot, row)] += 1;
+	}
+
+	PrescanPreview preview;
+	preview.rowCount = cache.rowCount();
+	preview.complete = prescan_->reachedEnd;
+
+	for(std::size_t entryIndex{0}; entryIndex < dictionary.size(); entryIndex++){
+		if(isCellValid(dictionary[entryIndex], column)) preview.validCount += entryCounts[entryIndex];
+	}
+
+	std::vector<std::size_t> entryOrder(dictionary.size());
+	std::iota(entryOrder.begin(), entryOrder.end(), 0);
+	const std::size_t frequentValueCount{std::min(dictionary.size(), Constants::PreviewFrequentValueCount)};
+	std::partial_sort(
+		entryOrder.begin(), entryOrder.begin() + frequentValueCount, entryOrder.end(),
+		[&entryCounts](const std::size_t left, const std::size_t right){ return entryCounts[left] > entryCounts[right]; }
+	);
+
+	for(std::size_t orderIndex{0}; orderIndex < frequentValueCount; orderIndex++){
+		const std::size_t entryIndex{entryOrder[orderIndex]};
+		preview.frequentValues.emplace_back(std::string{dictionary[entryIndex]}, entryCounts[entryIndex]);
+	}
+
+	return preview;
+}
+
+std::optional<NaNalyzer::PrescanPreview> NaNalyzer::previewCompleteness(const ColumnCombination &combination) const{
+	if(!prescan_) return std::nullopt;
+
+	const std::lock_guard prescanLock{prescan_->mutex};
+	const ColumnarCache &cache{prescan_->cache};
+
+	std::vector<char> isReferenced(headers_.size(), 0);
+	for(const ColumnOffset columnOffset : combination.columnOffsets()){
+		if(cache.columnSlot(columnOffset) < 0) return std::nullopt;
+		isReferenced[columnOffset] = 1;
+	}
+
+	std::vector<std::vector<char>> entryValidityByOffset(headers_.size());
+	std::vector<int> slotByOffset(headers_.size(), -1);
+	for(const auto &[fieldNumber, columnDefinition] : columns_){
+		if(!isReferenced[columnDefinition.index]) continue;
+
+		const int columnSlot{cache.columnSlot(columnDefinition.index)};
+		slotByOffset[columnDefinition.index] = columnSlot;
+		std::vector<char> &entryValidity{entryValidityByOffset[columnDefinition.index]};
+		for(const std::string_view entry : cache.dictionary(columnSlot)){
+			entryValidity.push_back(isCellValid(entry, columnDefinition));
+		}
+	}
+
+	PrescanPreview preview;
+	preview.rowCount = cache.rowCount();
+	preview.complete = prescan_->reachedEnd;
+
+	AdaptiveCombination combinationEvaluator{combination};
+	for(long long int row{0}; row < preview.rowCount; row++){
+		const bool isCombinationSatisfied{combinationEvaluator.evaluate(
+			[&](const ColumnOffset columnOffset){
+				return slotByOffset[columnOffset] >= 0
+					&& entryValidityByOffset[columnOffset][cache.code(slotByOffset[columnOffset], row)] != 0;
+			}
+		)};
+		if(isCombinationSatisfied) preview.validCount += 1;
+	}
+
+	return preview;
+}
+
+bool NaNalyzer::decideQualityGates(long long int rowCount, long long int remainingBytes){
+	bool isEveryGateDecided{true};
+
+	for(QualityGate &gate : qualityGates_){
+		if(gate.status != GateStatus::UNDECIDED) continue;
+
+		const double validRowCount{static_cast<double>(validCounts_[gate.combinationIndex])};
+		const double scannedRowCount{static_cast<double>(rowCount)};
+
+		// every row, even an empty line, takes at least one byte, and a satisfying row also needs a
+		// non empty cell behind the delimiters preceding the rightmost column the rule cannot do without
+		const ColumnOffset requiredColumnOffset{std::max(0, columnCombinationsToCheck_[gate.combinationIndex].requiredColumnOffset())};
+		const double maxRemainingRows{static_cast<double>(remainingBytes)};
+		const double maxRemainingValidRows{static_cast<double>(remainingBytes / (requiredColumnOffset + 1))};
+
+		if(validRowCount + maxRemainingValidRows < gate.minimumCompleteness * (scannedRowCount + maxRemainingValidRows)){
+			gate.status = GateStatus::FAILED; // even if every remaining byte formed valid rows
+		}else if(validRowCount >= gate.minimumCompleteness * (scannedRowCount + maxRemainingRows)){
+			gate.status = GateStatus::PASSED; // even if every remaining byte formed invalid rows
+		}else if(earlyExitMode_ == EarlyExitMode::SEQUENTIAL && rowCount > 0){
+			// Hoeffding bound with the error rate spread over all row counts as 6 / (pi^2 n^2), so the
+			// decision stays valid no matter at which row it is taken
+			constexpr double pi{3.14159265358979323846};
+			const double observedCompleteness{validRowCount / scannedRowCount};
+			const double radius{std::sqrt(
+				std::log(pi * pi * scannedRowCount * scannedRowCount / (3.0 * Constants::SequentialGateErrorRate)) / (2.0 * scannedRowCount)
+			)};
+
+			if(observedCompleteness + radius < gate.minimumCompleteness){
+				gate.status = GateStatus::FAILED;
+			}else if(observedCompleteness - radius >= gate.minimumCompleteness){
+				gate.status = GateStatus::PASSED;
+			}
+		}
+
+		if(gate.status == GateStatus::UNDECIDED){
+			isEveryGateDecided = false;
+		}else{
+			gate.decidedAtRow = rowCount;
+		}
+	}
+
+	return isEveryGateDecided;
+}
+
+void NaNalyzer::concludeQualityGates(long long int totalRowCount){
+	for(QualityGate &gate : qualityGates_){
+		if(gate.status != GateStatus::UNDECIDED) continue;
+
+		const double validRowCount{static_cast<double>(validCounts_[gate.combinationIndex])};
+		const bool isSatisfied{totalRowCount > 0 && validRowCount >= gate.minimumCompleteness * static_cast<double>(totalRowCount)};
+		gate.status = isSatisfied || gate.minimumCompleteness == 0.0 ? GateStatus::PASSED : GateStatus::FAILED;
+		gate.decidedAtRow = totalRowCount;
+	}
+}
+
+bool NaNalyzer::hasFailedQualityGate() const{
+	return std::any_of(qualityGates_.begin(), qualityGates_.end(), [](const QualityGate &gate){
+		return gate.status == GateStatus::FAILED;
+	});
+}
+
+void NaNalyzer::resetResults(){
+	validCounts_.assign(columnCombinationsToCheck_.size(), 0);
+
+	groupKeyArena_.clear();
+	groupIndex_.clear();
+	groupKeys_.clear();
+	groupRowCounts_.clear();
+	groupValidCounts_.clear();
+
+	distinctKeyArena_.clear();
+	distinctIndex_.clear();
+	distinctSatisfied_.clear();
+	distinctEntitySketch_ = HyperLogLog{};
+	distinctValidSketches_.assign(distinctMode_ == DistinctMode::HYPERLOGLOG ? columnCombinationsToCheck_.size() : 0, HyperLogLog{});
+
+	windowValidCounts_.assign(window_.has_value() ? columnCombinationsToCheck_.size() : 0, 0);
+
+	failedRowRanges_.assign(failedRowsFilePath_.has_value() ? columnCombinationsToCheck_.size() : 0, FailedRowRangeList{});
+
+	valueProfiles_.clear();
+	if(valueProfilePath_.has_value()){
+		for(const auto &[fieldNumber, columnDefinition] : columns_) valueProfiles_.push_back({fieldNumber, columnDefinition.index, TopKSketch{}});
+		std::sort(valueProfiles_.begin(), valueProfiles_.end(), [](const ValueProfile &left, const ValueProfile &right){
+			return left.fieldNumber < right.fieldNumber;
+		});
+	}
+
+	stoppedEarly_ = false;
+	for(QualityGate &gate : qualityGates_){
+		gate.status = GateStatus::UNDECIDED;
+		gate.decidedAtRow = 0;
+	}
 }
 
 void NaNalyzer::process(){
@@ -86,45 +979,177 @@ void NaNalyzer::process(){
 		throw std::runtime_error{"No column combinations were provided."};
 	}
 
+	if(!silentMode_) fmt::println("\nProcessing...");
+
+	// the baseline gets a scanner and thread of its own, so both files are read at the same time
+	std::unique_ptr<NaNalyzer> baselineAnalyzer;
+	std::thread baselineThread;
+	std::exception_ptr baselineException{nullptr};
+	long long int baselineRowCount{0};
+	bool baselineFromCache{false};
+	if(baselineFilePath_.has_value()){
+		baselineAnalyzer = makeBaselineAnalyzer();
+		baselineFromCache = baselineAnalyzer->loadCachedBaselineResult(deriveBaselineResultPath(baselineFilePath_.value()));
+
+		if(baselineFromCache){
+			baselineRowCount = baselineAnalyzer->scanTelemetry_.rowCount;
+		}else{
+			baselineThread = std::thread{[&baselineAnalyzer, &baselineRowCount, &baselineException, this](){
+				try{
+					baselineRowCount = baselineAnalyzer->scan();
+				}catch(const std::exception &exception){
+					baselineException = std::make_exception_ptr(std::runtime_error{fmt::format(
+						"Could not scan baseline '{}'. {}",
+						baselineFilePath_.value(),
+						exception.what()
+					)});
+				}
+			}};
+		}
+	}
+
+	long long int totalRowCount{0};
+	std::exception_ptr scanException{nullptr};
+	try{
+		totalRowCount = scan();
+	}catch(...){
+		scanException = std::current_exception();
+	}
+
+	if(baselineThread.joinable()) baselineThread.join();
+	if(scanException) std::rethrow_exception(scanException);
+	if(baselineException) std::rethrow_exception(baselineException);
+
+	if(baselineAnalyzer){
+		const FilePath baselineResultPath{deriveBaselineResultPath(baselineFilePath_.value())};
+		if(baselineFromCache){
+			if(!silentMode_) fmt::println("Baseline '{}' was taken from its saved result '{}'.", baselineFilePath_.value(), baselineResultPath);
+		}else{
+			try{
+				baselineAnalyzer->saveBaselineResult(baselineResultPath, baselineRowCount);
+				if(!silentMode_) fmt::println("Scanned baseline '{}' and saved its result to '{}'.", baselineFilePath_.value(), baselineResultPath);
+			}catch(const std::exception &exception){
+				// the comparison is still complete, only the next run has to scan the baseline again
+				fmt::println(stderr, "Warning: {}", exception.what());
+			}
+		}
+
+		baseline_ = Baseline{baselineFilePath_.value(), baselineRowCount, baselineAnalyzer->validCounts_, baselineFromCache};
+	}
+
+	if(byteRange_.has_value()){ // one shard of a larger scan, only merge reports the results
+		fmt::println("{}", formatResultsAsPartialJson(totalRowCount));
+		return;
+	}
+
+	if(valueProfilePath_.has_value()){
+		saveValueProfiles(valueProfilePath_.value());
+		if(!silentMode_) fmt::println("Saved value profiles and suggested invalid values to '{}'.", valueProfilePath_.value());
+	}
+
+	reportResults(totalRowCount);
+}
+
+long long int NaNalyzer::scan(){
 	static_assert(Constants::ProgressUpdateInterval.count() > 0, "Progress update interval must be positive.");
 	const auto updateInterval{Constants::ProgressUpdateInterval};
 
-	if(!silentMode_) fmt::println("\nProcessing...");
-
-	validCounts_.assign(columnCombinationsToCheck_.size(), 0);
+	resetResults();
 
 	std::atomic<long long int> processedRowCount{0};
-	std::atomic<bool> processingComplete{false};
+	std::atomic<long long int> processedByteCount{0};
+	CompletionSignal completionSignal;
 	std::exception_ptr workerException{nullptr};
 	long long int totalRowCount{0};
 
-	auto processingThread{std::thread{
-		&NaNalyzer::processCsvRows,
-		this,
-		std::chrono::duration_cast<std::chrono::steady_clock::duration>(updateInterval),
-		std::ref(processedRowCount),
-		std::ref(totalRowCount),
-		std::ref(processingComplete),
-		std::ref(workerException)
-	}};
-
-	const auto computedPollInterval{std::min(
-		std::chrono::duration_cast<std::chrono::milliseconds>(updateInterval),
-		Constants::ProgressDefaultPollInterval
-	)};
-	const auto pollInterval{computedPollInterval.count() > 0 ? computedPollInterval : Constants::ProgressMinimumPollInterval};
-
 	long long int lastDisplayedRowCount{0};
 	std::size_t maxProgressMessageWidth{0};
 	bool hasDisplayedProgress{false};
-	auto nextProgressDisplay{std::chrono::steady_clock::now() + updateInterval};
 
-	while(!processingComplete.load(std::memory_order_acquire)){
-		const auto now{std::chrono::steady_clock::now()};
-		if(now >= nextProgressDisplay){
+	std::error_code fileSizeError;
+	const auto csvFileSize{std::filesystem::file_size(csvFilePath_, fileSizeError)};
+	const bool isSmallFile{!fileSizeError && csvFileSize <= Constants::InlineProcessingMaxFileSize};
+	// following publishes its own updates from the scanning thread, so it never runs behind the progress display
+	const bool processInline{isSmallFile || followInterval_.has_value() || (silentMode_ && !metricsTextfilePath_.has_value())};
+
+	scanTelemetry_ = ScanTelemetry{0.0, 0, fileSizeError ? 0 : static_cast<long long int>(csvFileSize), 1, 0, 0, {}, 0.0};
+	const auto scanStart{std::chrono::steady_clock::now()};
+	const auto secondsSinceScanStart{[&scanStart](){
+		return std::chrono::duration<double>(std::chrono::steady_clock::now() - scanStart).count();
+	}};
+
+	// an interactive session may already hold every row in memory
+	const bool processedFromPrescan{awaitPrescan()};
+	if(processedFromPrescan){
+		columnarCache_ = std::move(prescan_->cache);
+		processColumnarCache(totalRowCount);
+		processedByteCount.store(scanTelemetry_.fileBytes, std::memory_order_relaxed);
+	}
+	stopPrescan();
+
+	bool processedFromCache{false};
+	if(cacheFilePath_.has_value() && !processedFromPrescan){
+		const ColumnarCache::SourceStamp sourceStamp{ColumnarCache::stampFile(csvFilePath_, dialect_)};
+
+		if(columnarCache_.load(cacheFilePath_.value(), sourceStamp) && canProcessFromColumnarCache(columnarCache_)){
+			processColumnarCache(totalRowCount);
+			processedFromCache = true;
+
+			std::error_code cacheSizeError;
+			const auto cacheFileSize{std::filesystem::file_size(cacheFilePath_.value(), cacheSizeError)};
+			processedByteCount.store(cacheSizeError ? 0 : static_cast<long long int>(cacheFileSize), std::memory_order_relaxed);
+		}else{
+			std::vector<int> cachedColumnOffsets;
+			for(const auto &columnEntry : columns_) cachedColumnOffsets.push_back(columnEntry.second.index);
+			if(groupByColumn_.has_value()) cachedColumnOffsets.push_back(groupByColumn_.value());
+			cachedColumnOffsets.insert(cachedColumnOffsets.end(), distinctOnColumns_.begin(), distinctOnColumns_.end());
+			for(const RowFilter &rowFilter : rowFilters_) cachedColumnOffsets.push_back(rowFilter.columnOffset());
+			std::sort(cachedColumnOffsets.begin(), cachedColumnOffsets.end());
+
+			columnarCache_.reset(sourceStamp, cachedColumnOffsets);
+		}
+	}
+
+	if(processedFromPrescan){
+		if(!silentMode_) fmt::println("Evaluated {} rows from the background pre-scan.", totalRowCount);
+	}else if(processedFromCache){
+		if(!silentMode_) fmt::println("Evaluated {} rows from columnar cache '{}'.", totalRowCount, cacheFilePath_.value());
+	}else if(processInline){ // nothing to report while it runs, so skip the progress thread entirely
+		processCsvRows(
+			std::chrono::duration_cast<std::chrono::steady_clock::duration>(updateInterval),
+			processedRowCount,
+			processedByteCount,
+			totalRowCount,
+			completionSignal,
+			workerException
+		);
+	}else{
+		auto processingThread{std::thread{
+			&NaNalyzer::processCsvRows,
+			this,
+			std::chrono::duration_cast<std::chrono::steady_clock::duration>(updateInterval),
+			std::ref(processedRowCount),
+			std::ref(processedByteCount),
+			std::ref(totalRowCount),
+			std::ref(completionSignal),
+			std::ref(workerException)
+		}};
+
+		auto nextProgressDisplay{std::chrono::steady_clock::now() + updateInterval};
+
+		std::unique_lock completionLock{completionSignal.mutex};
+		while(!completionSignal.condition.wait_until(
+			completionLock,
+			nextProgressDisplay,
+			[&completionSignal](){ return completionSignal.complete; }
+		)){
 			const long long int rowsProcessed{processedRowCount.load(std::memory_order_relaxed)};
-			if(!silentMode_ && rowsProcessed > 0 && rowsProcessed != lastDisplayedRowCount){
-				const std::string progressMessage{fmt::format("Processed {} rows...", rowsProcessed)};
+			if(!silentMode_ && !window_.has_value() && rowsProcessed > 0 && rowsProcessed != lastDisplayedRowCount){
+				const std::string progressMessage{fmt::format(
+					"Processed {} rows{}...",
+					rowsProcessed,
+					formatScanEstimate(processedByteCount.load(std::memory_order_relaxed), secondsSinceScanStart())
+				)};
 				if(progressMessage.size() > maxProgressMessageWidth){
 					maxProgressMessageWidth = progressMessage.size();
 				}
@@ -134,20 +1159,47 @@ void NaNalyzer::process(){
 				hasDisplayedProgress = true;
 			}
 
-			nextProgressDisplay = now + updateInterval;
+			if(metricsTextfilePath_.has_value()){
+				try{
+					writeMetricsTextfile(formatProgressAsOpenMetrics(
+						rowsProcessed,
+						processedByteCount.load(std::memory_order_relaxed),
+						secondsSinceScanStart()
+					));
+				}catch(const std::exception &exception){
+					// a dashboard missing an update must not abort the scan
+					fmt::println(stderr, "Failed to update metrics textfile: {}", exception.what());
+				}
+			}
+
+			nextProgressDisplay = std::chrono::steady_clock::now() + updateInterval;
 		}
+		completionLock.unlock();
 
-		std::this_thread::sleep_for(pollInterval);
+		processingThread.join();
 	}
 
-	processingThread.join();
-
 	if(workerException){
 		std::rethrow_exception(workerException);
 	}
 
+	MemoryStats::enterPhase(MemoryStats::Phase::RESULTS);
+
+	concludeQualityGates(totalRowCount);
+	if(!distinctOnColumns_.empty()) concludeDistinctCounts();
+
+	scanTelemetry_.durationSeconds = secondsSinceScanStart();
+	scanTelemetry_.bytesRead = processedByteCount.load(std::memory_order_relaxed);
+	scanTelemetry_.rowCount = totalRowCount;
+	if(scanThrottle_) scanTelemetry_.throttledSeconds = scanThrottle_->throttledSeconds();
+
+	if(metricsTextfilePath_.has_value()){
+		writeMetricsTextfile(formatResultsAsOpenMetrics(totalRowCount));
+		if(!silentMode_) fmt::println("Saved metrics to '{}'.", metricsTextfilePath_.value());
+	}
+
 	const long long int finalRowsProcessed{processedRowCount.load(std::memory_order_relaxed)};
-	if(!silentMode_ && finalRowsProcessed > lastDisplayedRowCount && finalRowsProcessed > 0){
+	if(!silentMode_ && !window_.has_value() && finalRowsProcessed > lastDisplayedRowCount && finalRowsProcessed > 0){
 		const std::string progressMessage{fmt::format("Processed {} rows...", finalRowsProcessed)};
 		if(progressMessage.size() > maxProgressMessageWidth){
 			maxProgressMessageWidth = progressMessage.size();
@@ -158,9 +1210,41 @@ void NaNalyzer::process(){
 	}
 	if(!silentMode_ && hasDisplayedProgress) fmt::print("\n");
 
+	if(cacheFilePath_.has_value() && !processedFromCache){
+		if(stoppedEarly_){
+			if(!silentMode_) fmt::println("Columnar cache skipped: the scan stopped early.");
+		}else if(columnarCache_.isBuilding()){
+			columnarCache_.save(cacheFilePath_.value());
+			if(!silentMode_) fmt::println("Saved columnar cache to '{}'.", cacheFilePath_.value());
+		}else if(!silentMode_){
+			fmt::println("Columnar cache skipped: a column has more than {} distinct values.", Constants::ColumnarCacheMaxDictionarySize);
+		}
+	}
+	columnarCache_.clear();
+
+	if(failedRowsFilePath_.has_value()){
+		saveFailedRowsToJson(failedRowsFilePath_.value());
+		if(!silentMode_){
+			fmt::println("Saved failing row ranges to '{}'.", failedRowsFilePath_.value());
+		}
+	}
+
+	if(splitCombinationIndex_.has_value() && !silentMode_){
+		fmt::println(
+			"Split rows by [{}] into '{}' and '{}'.",
+			formatCombinationForDisplay(columnCombinationsToCheck_[splitCombinationIndex_.value()]),
+			deriveSplitOutputPath("valid"),
+			deriveSplitOutputPath("rejected")
+		);
+	}
+
+	return totalRowCount;
+}
+
+void NaNalyzer::reportResults(long long int totalRowCount){
 	if(!silentMode_) fmt::println("\n--- Results ---");
 
-	if(totalRowCount == 0){
+	if(totalRowCount == 0 && outputFormat_ != OutputFormat::OPENMETRICS){ // a scrape still wants the zero
 		if(!silentMode_){
 			fmt::println("No data rows found to process.");
 			fmt::println("\nDone.");
@@ -169,7 +1253,11 @@ void NaNalyzer::process(){
 	}
 
 	if(!silentMode_){
-		fmt::println("Processed {} data rows.\n", totalRowCount);
+		if(stoppedEarly_){
+			fmt::println("Stopped after {} data rows: every quality gate was decided.\n", totalRowCount);
+		}else{
+			fmt::println("Processed {} data rows.\n", totalRowCount);
+		}
 	}
 
 	if(outputFormat_ == OutputFormat::JSON){
@@ -178,23 +1266,111 @@ void NaNalyzer::process(){
 		fmt::println("{}", formatResultsAsCsv(totalRowCount));
 	}else if(outputFormat_ == OutputFormat::KEYVALUE){
 		fmt::println("{}", formatResultsAsKeyValue(totalRowCount));
+	}else if(outputFormat_ == OutputFormat::OPENMETRICS){
+		fmt::println("{}", formatResultsAsOpenMetrics(totalRowCount));
 	}else{
-		for(std::size_t combinationIndex{0}; combinationIndex < columnCombinationsToCheck_.size(); combinationIndex++){
-			const long long int validRowCount{validCounts_[combinationIndex]};
-			float completenessPercentage{.0f};
-			if(totalRowCount > 0){
-				completenessPercentage = (static_cast<float>(validRowCount) / static_cast<float>(totalRowCount)) * 100.0f;
+		const auto printResults{[this](const long long int rowCount, const long long int *validRowCounts){
+			for(std::size_t combinationIndex{0}; combinationIndex < columnCombinationsToCheck_.size(); combinationIndex++){
+				const long long int validRowCount{validRowCounts[combinationIndex]};
+				float completenessPercentage{.0f};
+				if(rowCount > 0){
+					completenessPercentage = (static_cast<float>(validRowCount) / static_cast<float>(rowCount)) * 100.0f;
+				}
+
+				fmt::println(
+					"[{}] : {} / {} ({:.2f}%)",
+					formatCombinationForDisplay(columnCombinationsToCheck_[combinationIndex]),
+					validRowCount,
+					rowCount,
+					completenessPercentage
+				);
 			}
+		}};
+
+		printResults(totalRowCount, validCounts_.data());
+
+		for(std::size_t groupIndex{0}; groupIndex < groupKeys_.size(); groupIndex++){
+			fmt::println("\n--- Group '{}' ({} rows) ---", groupKeys_[groupIndex], groupRowCounts_[groupIndex]);
+			printResults(groupRowCounts_[groupIndex], &groupValidCounts_[groupIndex * columnCombinationsToCheck_.size()]);
+		}
+
+		if(!distinctOnColumns_.empty()){
+			std::vector<std::string_view> distinctFieldNames;
+			for(const ColumnOffset columnOffset : distinctOnColumns_) distinctFieldNames.push_back(headers_[columnOffset]);
+
+			fmt::println(
+				"\n--- Distinct {} ({}{} entities) ---",
+				fmt::join(distinctFieldNames, ", "),
+				distinctMode_ == DistinctMode::HYPERLOGLOG ? "~" : "",
+				distinctEntityCount_
+			);
+			printResults(distinctEntityCount_, distinctValidCounts_.data());
+		}
 
+		if(baseline_.has_value()){
 			fmt::println(
-				"[{}] : {} / {} ({:.2f}%)",
-				formatCombinationForDisplay(columnCombinationsToCheck_[combinationIndex]),
-				validRowCount,
-				totalRowCount,
-				completenessPercentage
+				"\n--- Baseline '{}' ({} rows{}) ---",
+				baseline_->csvFilePath,
+				baseline_->totalRowCount,
+				baseline_->fromCache ? ", saved result" : ""
 			);
+			for(std::size_t combinationIndex{0}; combinationIndex < columnCombinationsToCheck_.size(); combinationIndex++){
+				fmt::println("{}", formatBaselineDelta(combinationIndex, totalRowCount));
+			}
+		}
+
+		for(const ValueProfile &valueProfile : valueProfiles_){
+			const long long int rowCount{valueProfile.sketch.totalWeight()};
+			const std::vector<std::string> suggestions{suggestInvalidValues(valueProfile)};
+
+			fmt::println("\n--- Values of field {} ({}) ---", valueProfile.fieldNumber, columns_.at(valueProfile.fieldNumber).name);
+			const std::vector<TopKSketch::Entry> entries{valueProfile.sketch.entries()};
+			for(std::size_t entryIndex{0}; entryIndex < std::min(entries.size(), Constants::ValueProfileReportCount); entryIndex++){
+				const TopKSketch::Entry &entry{entries[entryIndex]};
+				fmt::println(
+					"'{}' : {} ({:.2f}%){}",
+					entry.value,
+					entry.overcount > 0 ? fmt::format("{}..{}", entry.count - entry.overcount, entry.count) : fmt::format("{}", entry.count),
+					rowCount > 0 ? static_cast<double>(entry.count) / static_cast<double>(rowCount) * 100.0 : 0.0,
+					std::find(suggestions.begin(), suggestions.end(), entry.value) != suggestions.end() ? " suggested invalid" : ""
+				);
+			}
+
+			if(!suggestions.empty()){
+				std::vector<std::string> quotedSuggestions;
+				for(const std::string &suggestion : suggestions) quotedSuggestions.push_back(fmt::format("'{}'", suggestion));
+				fmt::println("Suggested invalid values: {}", fmt::join(quotedSuggestions, ", "));
+			}
+		}
+
+		if(!qualityGates_.empty()) fmt::println("\n--- Quality gates ---");
+	}
+
+	for(const QualityGate &gate : qualityGates_){
+		const std::string gateMessage{fmt::format(
+			"[{}] >= {:.2f}% : {} (decided after {} rows)",
+			formatCombinationForDisplay(columnCombinationsToCheck_[gate.combinationIndex]),
+			gate.minimumCompleteness * 100.0,
+			gate.status == GateStatus::PASSED ? "passed" : "FAILED",
+			gate.decidedAtRow
+		)};
+
+		// machine readable formats keep stdout parseable, failing gates still show up in CI logs
+		if(outputFormat_ == OutputFormat::TEXT){
+			fmt::println("{}", gateMessage);
+		}else if(gate.status == GateStatus::FAILED){
+			fmt::println(stderr, "Quality gate {}", gateMessage);
+		}
+	}
+
+	// as with the gates, csv and keyvalue output stays parseable and regressions go to stderr
+	if(baseline_.has_value() && (outputFormat_ == OutputFormat::CSV || outputFormat_ == OutputFormat::KEYVALUE)){
+		for(std::size_t combinationIndex{0}; combinationIndex < columnCombinationsToCheck_.size(); combinationIndex++){
+			if(compareWithBaseline(combinationIndex, totalRowCount).isRegression){
+				fmt::println(stderr, "Baseline regression {}", formatBaselineDelta(combinationIndex, totalRowCount));
+			}
 		}
 	}
 
 	if(!silentMode_) fmt::println("\nDone.");
-}
\ No newline at end of file
+}
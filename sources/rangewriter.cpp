@@ -0,0 +1,175 @@
+#include "rangewriter.hpp"
+
+#include <fmt/core.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+
+#if defined(__linux__)
+    #include <fcntl.h>
+    #include <unistd.h>
+#endif
+
+#include "constants.hpp"
+
+void ByteRangeWriter::AlignedDelete::operator()(char *buffer) const{
+    ::operator delete[](buffer, std::align_val_t{Constants::CopyBufferAlignment});
+}
+
+ByteRangeWriter::ByteRangeWriter(const std::string &sourcePath, const std::string &destinationPath)
+    : destinationPath_{destinationPath}
+{
+#if defined(__linux__)
+    sourceDescriptor_ = ::open(sourcePath.c_str(), O_RDONLY | O_CLOEXEC);
+    if(sourceDescriptor_ < 0){
+        throw std::runtime_error{fmt::format("Could not open '{}' for reading. {}", sourcePath, std::strerror(errno))};
+    }
+
+    destinationDescriptor_ = ::open(destinationPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if(destinationDescriptor_ < 0){
+        const int openError{errno};
+        ::close(sourceDescriptor_);
+        throw std::runtime_error{fmt::format("Could not open '{}' for writing. {}", destinationPath, std::strerror(openError))};
+    }
+#else
+    sourceFile_.open(sourcePath, std::ios::binary);
+    if(!sourceFile_){
+        throw std::runtime_error{fmt::format("Could not open '{}' for reading.", sourcePath)};
+    }
+
+    destinationFile_.open(destinationPath, std::ios::binary | std::ios::trunc);
+    if(!destinationFile_){
+        throw std::runtime_error{fmt::format("Could not open '{}' for writing.", destinationPath)};
+    }
+#endif
+}
+
+ByteRangeWriter::~ByteRangeWriter(){
+#if defined(__linux__)
+    if(sourceDescriptor_ >= 0) ::close(sourceDescriptor_);
+    if(destinationDescriptor_ >= 0) ::close(destinationDescriptor_);
+#endif
+}
+
+void ByteRangeWriter::append(long long int firstByte, long long int endByte){
+    if(endByte <= firstByte) return;
+
+    if(firstByte == pendingEndByte_ && pendingEndByte_ > pendingFirstByte_){
+        pendingEndByte_ = endByte;
+        return;
+    }
+
+    copyPendingRange();
+    pendingFirstByte_ = firstByte;
+    pendingEndByte_ = endByte;
+}
+
+void ByteRangeWriter::finish(){
+    copyPendingRange();
+
+#if defined(__linux__)
+    if(destinationDescriptor_ >= 0 && ::close(destinationDescriptor_) != 0){
+        destinationDescriptor_ = -1;
+        throw std::runtime_error{fmt::format("Failed to write '{}'. {}", destinationPath_, std::strerror(errno))};
+    }
+    destinationDescriptor_ = -1;
+#else
+    destinationFile_.flush();
+    if(!destinationFile_){
+        throw std::runtime_error{fmt::format("Failed to write '{}'.", destinationPath_)};
+    }
+#endif
+}
+
+void ByteRangeWriter::copyPendingRange(){
+    if(pendingEndByte_ <= pendingFirstByte_) return;
+
+    const long long int firstByte{pendingFirstByte_};
+    const long long int endByte{pendingEndByte_};
+    pendingFirstByte_ = pendingEndByte_ = 0;
+
+#if defined(__linux__)
+    if(useCopyFileRange_){
+        off_t sourceOffset{static_cast<off_t>(firstByte)};
+        long long int remaining{endByte - firstByte};
+
+        while(remaining > 0){
+            const ssize_t copied{::copy_file_range(
+                sourceDescriptor_, &sourceOffset,
+                destinationDescriptor_, nullptr,
+                static_cast<std::size_t>(remaining), 0
+            )};
+
+            if(copied > 0){
+                remaining -= copied;
+                bytesWritten_ += copied;
+                continue;
+            }
+
+            if(copied == 0) return; // the last line had no terminator, the range ran past the end of file
+
+            if(errno == EINTR) continue;
+            if(errno == ENOSYS || errno == EXDEV || errno == EINVAL || errno == EOPNOTSUPP){
+                // older kernels and some filesystem pairs refuse the in-kernel copy
+                useCopyFileRange_ = false;
+                copyThroughBuffer(static_cast<long long int>(sourceOffset), endByte);
+                return;
+            }
+
+            throw std::runtime_error{fmt::format("Failed to write '{}'. {}", destinationPath_, std::strerror(errno))};
+        }
+        return;
+    }
+#endif
+
+    copyThroughBuffer(firstByte, endByte);
+}
+
+void ByteRangeWriter::copyThroughBuffer(long long int firstByte, long long int endByte){
+    if(!copyBuffer_){
+        copyBuffer_.reset(new(std::align_val_t{Constants::CopyBufferAlignment}) char[Constants::CopyBufferSize]);
+    }
+
+    long long int position{firstByte};
+    while(position < endByte){
+        const std::size_t chunkSize{static_cast<std::size_t>(std::min<long long int>(
+            endByte - position,
+            static_cast<long long int>(Constants::CopyBufferSize)
+        ))};
+
+#if defined(__linux__)
+        const ssize_t bytesRead{::pread(sourceDescriptor_, copyBuffer_.get(), chunkSize, static_cast<off_t>(position))};
+        if(bytesRead < 0){
+            if(errno == EINTR) continue;
+            throw std::runtime_error{fmt::format("Failed to read source while writing '{}'. {}", destinationPath_, std::strerror(errno))};
+        }
+        if(bytesRead == 0) return;
+
+        for(ssize_t written{0}; written < bytesRead;){
+            const ssize_t result{::write(destinationDescriptor_, copyBuffer_.get() + written, static_cast<std::size_t>(bytesRead - written))};
+            if(result < 0){
+                if(errno == EINTR) continue;
+                throw std::runtime_error{fmt::format("Failed to write '{}'. {}", destinationPath_, std::strerror(errno))};
+            }
+            written += result;
+        }
+#else
+        sourceFile_.clear();
+        sourceFile_.seekg(position);
+        sourceFile_.read(copyBuffer_.get(), static_cast<std::streamsize>(chunkSize));
+        const long long int bytesRead{static_cast<long long int>(sourceFile_.gcount())};
+        if(bytesRead <= 0) return;
+
+        destinationFile_.write(copyBuffer_.get(), bytesRead);
+        if(!destinationFile_){
+            throw std::runtime_error{fmt::format("Failed to write '{}'.", destinationPath_)};
+        }
+#endif
+
+        position += bytesRead;
+        bytesWritten_ += bytesRead;
+    }
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <fstream>
+#include <memory>
+#include <string>
+
+// Copies byte ranges of a source file into a destination file without re-serializing them.
+// Adjacent ranges are coalesced so a run of consecutive lines becomes a single copy, which
+// is handed to copy_file_range on Linux (kernel side, no user space copy) and otherwise
+// streamed through one large aligned buffer.
+class ByteRangeWriter{
+public:
+    ByteRangeWriter(const std::string &sourcePath, const std::string &destinationPath);
+    ~ByteRangeWriter();
+
+    ByteRangeWriter(const ByteRangeWriter &) = delete;
+    ByteRangeWriter &operator=(const ByteRangeWriter &) = delete;
+
+    void append(long long int firstByte, long long int endByte);
+    void finish(); // copies whatever is still pending; must be called before destruction to see errors
+
+    long long int bytesWritten() const{ return bytesWritten_; }
+
+private:
+    void copyPendingRange();
+    void copyThroughBuffer(long long int firstByte, long long int endByte);
+
+private:
+    std::string destinationPath_;
+
+#if defined(__linux__)
+    int sourceDescriptor_{-1};
+    int destinationDescriptor_{-1};
+    bool useCopyFileRange_{true};
+#else
+    std::ifstream sourceFile_;
+    std::ofstream destinationFile_;
+#endif
+
+    struct AlignedDelete{
+        void operator()(char *buffer) const;
+    };
+    std::unique_ptr<char[], AlignedDelete> copyBuffer_;
+
+    long long int pendingFirstByte_{0};
+    long long int pendingEndByte_{0};
+    long long int bytesWritten_{0};
+};
@@ -0,0 +1,42 @@
+#include "recordreader.hpp"
+
+#include <algorithm>
+
+CsvRecordReader::CsvRecordReader(const std::string &filePath, const std::vector<int> &retainedColumnOffsets, bool completeRecordsOnly, bool directIo, ScanThrottle *throttle)
+    : blockReader_{filePath, directIo, throttle}
+    , completeRecordsOnly_{completeRecordsOnly}
+{
+    for(const int columnOffset : retainedColumnOffsets){
+        if(columnOffset < 0) continue;
+        if(columnOffset >= static_cast<int>(isRetained_.size())) isRetained_.resize(columnOffset + 1, 0);
+        isRetained_[columnOffset] = 1;
+    }
+    cellStorage_.resize(isRetained_.size());
+}
+
+bool CsvRecordReader::refill(){
+    const BlockReader::Block block{blockReader_.next()};
+    buffer_ = block.data;
+    bufferFileOffset_ = block.fileOffset;
+    position_ = 0;
+    bufferEnd_ = block.size;
+    return bufferEnd_ > 0;
+}
+
+void CsvRecordReader::seekToRecordAt(long long int fileOffset){
+    if(fileOffset <= 0) return;
+
+    // a record starts right at fileOffset exactly when the byte before it ends a line
+    rewindTo(fileOffset - 1);
+    while(hasByte()){
+        if(buffer_[position_++] == '\n') return;
+    }
+}
+
+void CsvRecordReader::rewindTo(long long int fileOffset){
+    blockReader_.seek(fileOffset);
+
+    bufferFileOffset_ = fileOffset;
+    position_ = 0;
+    bufferEnd_ = 0;
+}
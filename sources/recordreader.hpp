@@ -0,0 +1,184 @@
+#pragma once
+
+#include <cstddef>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "blockreader.hpp"
+#include "tokenizer.hpp"
+
+// Streams CSV records through fixed-size blocks, so rows of any length can be read. The blocks
+// come from a BlockReader, which reads ahead asynchronously where the system allows it.
+//
+// Only the fields whose offsets were marked as retained are copied out of the buffer, into
+// storage that is reused from row to row. Every other field is skipped in place without
+// being buffered, so memory depends on the retained cells only, never on the row width.
+// Quoted fields may span buffer refills and, as in RFC 4180, contain line breaks.
+//
+// A file that is still being written can be followed with completeRecordsOnly: a last record
+// without its line feed is left unread, and once the end of the file is reached, later calls
+// pick up whatever was appended since.
+class CsvRecordReader{
+public:
+    CsvRecordReader(const std::string &filePath, const std::vector<int> &retainedColumnOffsets, bool completeRecordsOnly = false, bool directIo = false, ScanThrottle *throttle = nullptr);
+
+    // Reads the next record and fills fields with one entry per column up to the highest
+    // retained offset (fewer if the record is shorter). Retained columns point into reader
+    // owned storage that stays valid until the next call, all others are empty.
+    template<char Delimiter, char Quote, bool Trim>
+    bool readRecord(RowTokenizer<Delimiter, Quote, Trim>, RowFieldList &fields);
+
+    // Retains every column, however many the records have, e.g. to read the header. Memory then
+    // grows with the widest record, so scans retain only the offsets they need.
+    void retainAllColumns(){ retainsAllColumns_ = true; }
+
+    // Reads the next record with every column retained, then goes back to the retained offsets,
+    // e.g. to check the header of a file that replaced the one being followed.
+    template<char Delimiter, char Quote, bool Trim>
+    bool readFullRecord(RowTokenizer<Delimiter, Quote, Trim> tokenizeRow, RowFieldList &fields);
+
+    // Continues with the first record that starts at or after fileOffset, found by the next line
+    // feed. Only exact where no quoted field spans that point with a line break of its own.
+    void seekToRecordAt(long long int fileOffset);
+
+    long long int recordOffset() const{ return recordOffset_; } // first byte of the last record read
+    long long int recordLength() const{ return recordLength_; } // including its line terminator
+    long long int bytesConsumed() const{ return bufferFileOffset_ + static_cast<long long int>(position_); }
+
+    bool usesIoUring() const{ return blockReader_.usesIoUring(); }
+    bool usesDirectIo() const{ return blockReader_.usesDirectIo(); }
+
+private:
+    bool refill(); // false at end of file
+    void rewindTo(long long int fileOffset);
+
+    bool hasByte(){ return position_ < bufferEnd_ || refill(); }
+
+    template<char Delimiter>
+    static const char *findFieldEnd(const char *begin, const char *end){
+        for(const char *cursor{begin}; cursor < end; cursor++){
+            if(*cursor == Delimiter || *cursor == '\n') return cursor;
+        }
+        return end;
+    }
+
+private:
+    BlockReader blockReader_;
+    const char *buffer_{nullptr}; // the current block, owned by blockReader_
+    std::size_t position_{0};
+    std::size_t bufferEnd_{0};
+    long long int bufferFileOffset_{0}; // file offset of buffer_[0]
+
+    std::vector<char> isRetained_;          // indexed by column offset
+    std::vector<std::string> cellStorage_;  // indexed by column offset, only retained ones are used
+
+    bool completeRecordsOnly_;
+    bool retainsAllColumns_{false};
+
+    long long int recordOffset_{0};
+    long long int recordLength_{0};
+};
+
+template<char Delimiter, char Quote, bool Trim>
+bool CsvRecordReader::readRecord(RowTokenizer<Delimiter, Quote, Trim>, RowFieldList &fields){
+    using Tokenizer = RowTokenizer<Delimiter, Quote, Trim>;
+
+    fields.clear();
+    if(!hasByte()) return false;
+
+    recordOffset_ = bytesConsumed();
+
+    bool endedAtEndOfFile{false};
+    for(std::size_t fieldIndex{0};; fieldIndex++){
+        if(retainsAllColumns_ && fieldIndex >= isRetained_.size()){
+            isRetained_.push_back(1);
+            cellStorage_.emplace_back();
+        }
+        std::string *cell{fieldIndex < isRetained_.size() && isRetained_[fieldIndex] ? &cellStorage_[fieldIndex] : nullptr};
+        if(cell) cell->clear();
+
+        if constexpr(Trim){
+            while(hasByte() && Tokenizer::isTrimmable(buffer_[position_])) position_++;
+        }
+
+        bool isQuoted{false};
+        if constexpr(Quote != '\0'){
+            if(hasByte() && buffer_[position_] == Quote){
+                isQuoted = true;
+                position_++;
+
+                while(hasByte()){
+                    const char *chunkBegin{buffer_ + position_};
+                    const char *closingQuote{static_cast<const char *>(std::memchr(chunkBegin, Quote, bufferEnd_ - position_))};
+                    const char *chunkEnd{closingQuote ? closingQuote : buffer_ + bufferEnd_};
+
+                    if(cell) cell->append(chunkBegin, static_cast<std::size_t>(chunkEnd - chunkBegin));
+                    position_ = static_cast<std::size_t>(chunkEnd - buffer_);
+                    if(!closingQuote) continue;
+
+                    position_++; // the quote itself
+                    if(!hasByte() || buffer_[position_] != Quote) break;
+
+                    if(cell) cell->push_back(Quote); // doubled quote is an escaped quote
+                    position_++;
+                }
+            }
+        }
+
+        // unquoted content, or whatever trails a closing quote, runs up to the delimiter or line end
+        while(hasByte()){
+            const char *chunkBegin{buffer_ + position_};
+            const char *chunkEnd{findFieldEnd<Delimiter>(chunkBegin, buffer_ + bufferEnd_)};
+
+            if(cell && !isQuoted) cell->append(chunkBegin, static_cast<std::size_t>(chunkEnd - chunkBegin));
+            position_ = static_cast<std::size_t>(chunkEnd - buffer_);
+            if(position_ < bufferEnd_) break;
+        }
+
+        endedAtEndOfFile = !hasByte();
+        const bool endsRecord{endedAtEndOfFile || buffer_[position_] == '\n'};
+
+        if(cell && !isQuoted){
+            if constexpr(Trim){
+                while(!cell->empty() && Tokenizer::isTrimmable(cell->back())) cell->pop_back();
+            }else{
+                if(endsRecord && !cell->empty() && cell->back() == '\r') cell->pop_back();
+            }
+        }
+
+        if(fieldIndex < isRetained_.size()){
+            fields.push_back(cell ? std::string_view{*cell} : std::string_view{});
+        }
+
+        if(hasByte()) position_++; // delimiter or line feed
+        if(endsRecord) break;
+    }
+
+    if(endedAtEndOfFile && completeRecordsOnly_){ // the writer has not finished this record yet
+        rewindTo(recordOffset_);
+        fields.clear();
+        return false;
+    }
+
+    if(retainsAllColumns_){ // growing cellStorage_ may have moved the cells read before
+        for(std::size_t fieldIndex{0}; fieldIndex < fields.size(); fieldIndex++) fields[fieldIndex] = cellStorage_[fieldIndex];
+    }
+
+    recordLength_ = bytesConsumed() - recordOffset_;
+    return true;
+}
+
+template<char Delimiter, char Quote, bool Trim>
+bool CsvRecordReader::readFullRecord(RowTokenizer<Delimiter, Quote, Trim> tokenizeRow, RowFieldList &fields){
+    const std::vector<char> retainedOffsets{std::exchange(isRetained_, std::vector<char>(isRetained_.size(), 1))};
+    const bool wasRetainingAll{std::exchange(retainsAllColumns_, true)};
+
+    const bool hasRecord{readRecord(tokenizeRow, fields)};
+
+    isRetained_ = retainedOffsets; // cellStorage_ keeps its size, the cells just go unused
+    retainsAllColumns_ = wasRetainingAll;
+    return hasRecord;
+}
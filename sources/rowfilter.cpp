@@ -0,0 +1,98 @@
+#include "rowfilter.hpp"
+
+#include <fmt/core.h>
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace{
+
+    std::string_view trimmed(std::string_view text){
+        const std::size_t first{text.find_first_not_of(" \t")};
+        if(first == std::string_view::npos) return {};
+        const std::size_t last{text.find_last_not_of(" \t")};
+        return text.substr(first, last - first + 1);
+    }
+
+    std::string unquoted(std::string_view text){
+        text = trimmed(text);
+        if(text.size() >= 2 && text.front() == '"' && text.back() == '"') text = text.substr(1, text.size() - 2);
+        return std::string{text};
+    }
+
+} // namespace
+
+RowFilter::RowFilter(std::string_view specification, const std::vector<std::string> &headers)
+    : specification_{trimmed(specification)}
+{
+    const auto fail{[&specification](const std::string &message){
+        throw std::invalid_argument{fmt::format("Invalid filter '{}': {}.", specification, message)};
+    }};
+
+    const std::string_view filterText{specification_};
+    std::string_view fieldText;
+    if(filterText.empty()) fail("the filter is empty");
+
+    const std::size_t comparisonPosition{std::min(filterText.find("=="), filterText.find("!="))};
+    if(comparisonPosition != std::string_view::npos){
+        fieldText = filterText.substr(0, comparisonPosition);
+        negated_ = filterText[comparisonPosition] == '!';
+        values_.push_back(unquoted(filterText.substr(comparisonPosition + 2)));
+    }else{
+        // the set starts at the first brace, so the operator is the last " in" before it; header
+        // names may contain the word as well
+        const std::size_t bracePosition{filterText.find('{')};
+        if(bracePosition == std::string_view::npos || filterText.back() != '}'){
+            fail("expected field == value, field != value, field in {a, b} or field not in {a, b}");
+        }
+
+        const std::size_t operatorPosition{filterText.rfind(" in", bracePosition)};
+        if(operatorPosition == std::string_view::npos || !trimmed(filterText.substr(operatorPosition + 3, bracePosition - operatorPosition - 3)).empty()){
+            fail("a value set must follow 'in' or 'not in'");
+        }
+
+        fieldText = filterText.substr(0, operatorPosition);
+        if(fieldText.size() >= 4 && fieldText.substr(fieldText.size() - 4) == " not"){
+            negated_ = true;
+            fieldText.remove_suffix(4);
+        }
+
+        std::string_view remaining{filterText.substr(bracePosition + 1, filterText.size() - bracePosition - 2)};
+        while(!trimmed(remaining).empty()){
+            const std::size_t commaPosition{remaining.find(',')};
+            values_.push_back(unquoted(remaining.substr(0, commaPosition)));
+            if(commaPosition == std::string_view::npos) break;
+            remaining.remove_prefix(commaPosition + 1);
+        }
+    }
+
+    fieldText = trimmed(fieldText);
+    if(fieldText.empty()) fail("the field is missing");
+
+    const auto headerMatch{std::find(headers.begin(), headers.end(), fieldText)};
+    if(headerMatch != headers.end()){
+        columnOffset_ = static_cast<int>(headerMatch - headers.begin());
+    }else{
+        int fieldNumber{0};
+        try{
+            std::size_t parsedLength{0};
+            fieldNumber = std::stoi(std::string{fieldText}, &parsedLength);
+            if(parsedLength != fieldText.size()) fieldNumber = 0;
+        }catch(const std::exception &){
+            fieldNumber = 0;
+        }
+
+        if(fieldNumber < 1 || fieldNumber > static_cast<int>(headers.size())){
+            fail(fmt::format("'{}' is neither a header name nor a field number between 1 and {}", fieldText, headers.size()));
+        }
+        columnOffset_ = fieldNumber - 1;
+    }
+
+    std::sort(values_.begin(), values_.end());
+    values_.erase(std::unique(values_.begin(), values_.end()), values_.end());
+}
+
+bool RowFilter::accepts(std::string_view cell) const{
+    const bool isListed{std::binary_search(values_.begin(), values_.end(), cell, std::less<>{})};
+    return isListed != negated_;
+}
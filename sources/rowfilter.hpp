@@ -0,0 +1,28 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+// A row predicate such as "status == ACTIVE" or "country in {US, CA}". Rows failing any filter
+// are left out of every count, as if the file had been filtered before the scan.
+//
+// Specification syntax: <field> == <value>, <field> != <value>, <field> in {<value>, ...} or
+// <field> not in {<value>, ...}, where <field> is a header name or a 1 based field number.
+// Values are trimmed; double quotes around a value keep its surrounding spaces and make the
+// empty value "" expressible.
+class RowFilter{
+public:
+    RowFilter(std::string_view specification, const std::vector<std::string> &headers);
+
+    const std::string &specification() const{ return specification_; }
+    int columnOffset() const{ return columnOffset_; } // 0 based
+
+    bool accepts(std::string_view cell) const;
+
+private:
+    std::string specification_;
+    int columnOffset_{-1};
+    bool negated_{false};
+    std::vector<std::string> values_; // sorted
+};
@@ -0,0 +1,289 @@
+#include "ruleexpression.hpp"
+
+#include <fmt/core.h>
+#include <fmt/ranges.h>
+
+#include <algorithm>
+#include <cctype>
+#include <stdexcept>
+
+namespace{
+
+    RuleExpression::Node normalize(RuleExpression::Node node){
+        using Kind = RuleExpression::Kind;
+
+        for(RuleExpression::Node &operand : node.operands) operand = normalize(std::move(operand));
+
+        if(node.kind == Kind::NOT && node.operands.front().kind == Kind::NOT){
+            return std::move(node.operands.front().operands.front());
+        }
+
+        // at least one is any, at least all is every
+        if(node.kind == Kind::AT_LEAST && node.minimumCount == 1) node.kind = Kind::OR;
+        if(node.kind == Kind::AT_LEAST && node.minimumCount == static_cast<int>(node.operands.size())) node.kind = Kind::AND;
+
+        if(node.kind == Kind::AND || node.kind == Kind::OR){
+            node.minimumCount = 0;
+
+            std::vector<RuleExpression::Node> flattened;
+            for(RuleExpression::Node &operand : node.operands){
+                if(operand.kind == node.kind){
+                    for(RuleExpression::Node &nestedOperand : operand.operands) flattened.push_back(std::move(nestedOperand));
+                }else{
+                    flattened.push_back(std::move(operand));
+                }
+            }
+            if(flattened.size() == 1) return std::move(flattened.front());
+            node.operands = std::move(flattened);
+        }
+
+        return node;
+    }
+
+    // recursive descent over: or := and ('|' and)*, and := unary ('&' unary)*,
+    // unary := '!' unary | primary, primary := number | '(' or ')' | atleast '(' number (',' or)+ ')'
+    class RuleParser{
+    public:
+        explicit RuleParser(std::string_view text) : text_{text}{}
+
+        RuleExpression::Node parseRule(){
+            RuleExpression::Node root{parseOr()};
+            skipWhitespace();
+            if(position_ < text_.size()) fail(fmt::format("unexpected '{}'", text_[position_]));
+            return root;
+        }
+
+    private:
+        RuleExpression::Node parseOr(){
+            RuleExpression::Node node{parseAnd()};
+            bool isGrouped{false};
+            while(accept('|')){
+                if(!isGrouped){
+                    node = RuleExpression::Node{RuleExpression::Kind::OR, -1, 0, {std::move(node)}};
+                    isGrouped = true;
+                }
+                node.operands.push_back(parseAnd());
+            }
+            return node;
+        }
+
+        RuleExpression::Node parseAnd(){
+            RuleExpression::Node node{parseUnary()};
+            bool isGrouped{false};
+            while(accept('&')){
+                if(!isGrouped){
+                    node = RuleExpression::Node{RuleExpression::Kind::AND, -1, 0, {std::move(node)}};
+                    isGrouped = true;
+                }
+                node.operands.push_back(parseUnary());
+            }
+            return node;
+        }
+
+        RuleExpression::Node parseUnary(){
+            if(accept('!')) return RuleExpression::Node{RuleExpression::Kind::NOT, -1, 0, {parseUnary()}};
+            return parsePrimary();
+        }
+
+        RuleExpression::Node parsePrimary(){
+            skipWhitespace();
+
+            if(accept('(')){
+                RuleExpression::Node node{parseOr()};
+                expect(')');
+                return node;
+            }
+
+            if(text_.substr(position_).starts_with("atleast")){
+                position_ += std::string_view{"atleast"}.size();
+                expect('(');
+                RuleExpression::Node node{RuleExpression::Kind::AT_LEAST, -1, parseNumber("a count"), {}};
+                while(accept(',')) node.operands.push_back(parseOr());
+                expect(')');
+
+                if(node.minimumCount < 1 || node.minimumCount > static_cast<int>(node.operands.size())){
+                    fail(fmt::format("atleast({}, ...) needs between 1 and its {} operands", node.minimumCount, node.operands.size()));
+                }
+                return node;
+            }
+
+            const int fieldNumber{parseNumber("a field number")};
+            if(fieldNumber < 1) fail("field numbers start at 1");
+            return RuleExpression::Node{RuleExpression::Kind::FIELD, fieldNumber - 1, 0, {}};
+        }
+
+        int parseNumber(std::string_view expected){
+            skipWhitespace();
+            const std::size_t start{position_};
+            long long int number{0};
+            while(position_ < text_.size() && std::isdigit(static_cast<unsigned char>(text_[position_]))){
+                number = std::min<long long int>(number * 10 + (text_[position_] - '0'), 1LL << 31);
+                position_ += 1;
+            }
+            if(position_ == start) fail(fmt::format("expected {}", expected));
+            if(number >= (1LL << 31)) fail("number too large");
+            return static_cast<int>(number);
+        }
+
+        bool accept(char symbol){
+            skipWhitespace();
+            if(position_ < text_.size() && text_[position_] == symbol){
+                position_ += 1;
+                return true;
+            }
+            return false;
+        }
+
+        void expect(char symbol){
+            if(!accept(symbol)) fail(fmt::format("expected '{}'", symbol));
+        }
+
+        void skipWhitespace(){
+            while(position_ < text_.size() && std::isspace(static_cast<unsigned char>(text_[position_]))) position_ += 1;
+        }
+
+        [[noreturn]] void fail(const std::string &reason) const{
+            throw std::invalid_argument{fmt::format("Invalid rule '{}': {} at position {}.", text_, reason, position_ + 1)};
+        }
+
+    private:
+        std::string_view text_;
+        std::size_t position_{0};
+    };
+
+    void collectColumnOffsets(const RuleExpression::Node &node, std::vector<int> &columnOffsets){
+        if(node.kind == RuleExpression::Kind::FIELD && node.columnOffset >= 0) columnOffsets.push_back(node.columnOffset);
+        for(const RuleExpression::Node &operand : node.operands) collectColumnOffsets(operand, columnOffsets);
+    }
+
+    int requiredColumnOffset(const RuleExpression::Node &node){
+        switch(node.kind){
+            case RuleExpression::Kind::FIELD:
+                return node.columnOffset;
+            case RuleExpression::Kind::NOT:
+                return -1; // satisfied by a missing cell
+            case RuleExpression::Kind::AND:{
+                int required{-1};
+                for(const RuleExpression::Node &operand : node.operands) required = std::max(required, requiredColumnOffset(operand));
+                return required;
+            }
+            case RuleExpression::Kind::OR:
+            case RuleExpression::Kind::AT_LEAST:{
+                // the cheapest way to satisfy it takes the operands requiring the leftmost columns
+                std::vector<int> required;
+                for(const RuleExpression::Node &operand : node.operands) required.push_back(requiredColumnOffset(operand));
+                std::sort(required.begin(), required.end());
+                return required[node.kind == RuleExpression::Kind::OR ? 0 : node.minimumCount - 1];
+            }
+        }
+        return -1;
+    }
+
+    // precedence: 1 for '|', 2 for '&', 3 for '!', 4 for anything that needs no parentheses
+    std::string formatNode(const RuleExpression::Node &node, int enclosingPrecedence){
+        std::string formatted;
+        int precedence{4};
+
+        switch(node.kind){
+            case RuleExpression::Kind::FIELD:
+                formatted = fmt::format("{}", node.columnOffset + 1);
+                break;
+            case RuleExpression::Kind::NOT:
+                formatted = "!" + formatNode(node.operands.front(), 3);
+                precedence = 3;
+                break;
+            case RuleExpression::Kind::AND:
+            case RuleExpression::Kind::OR:{
+                precedence = node.kind == RuleExpression::Kind::AND ? 2 : 1;
+                std::vector<std::string> operands;
+                for(const RuleExpression::Node &operand : node.operands) operands.push_back(formatNode(operand, precedence));
+                formatted = fmt::format("{}", fmt::join(operands, precedence == 2 ? " & " : " | "));
+                break;
+            }
+            case RuleExpression::Kind::AT_LEAST:{
+                std::vector<std::string> operands;
+                for(const RuleExpression::Node &operand : node.operands) operands.push_back(formatNode(operand, 0));
+                formatted = fmt::format("atleast({}, {})", node.minimumCount, fmt::join(operands, ", "));
+                break;
+            }
+        }
+
+        return precedence < enclosingPrecedence ? "(" + formatted + ")" : formatted;
+    }
+
+} // namespace
+
+RuleExpression::RuleExpression(Node root)
+    : root_{normalize(std::move(root))}
+{
+}
+
+RuleExpression RuleExpression::parse(std::string_view text){
+    return RuleExpression{RuleParser{text}.parseRule()};
+}
+
+RuleExpression RuleExpression::fromClauses(const std::vector<std::vector<int>> &clauses){
+    if(clauses.empty()) return RuleExpression{};
+    if(std::any_of(clauses.begin(), clauses.end(), [](const std::vector<int> &clause){ return clause.empty(); })){
+        throw std::invalid_argument{"A combination needs at least one field in each group."};
+    }
+
+    Node root{Kind::AND, -1, 0, {}};
+    for(const std::vector<int> &clause : clauses){
+        Node &disjunction{root.operands.emplace_back(Node{Kind::OR, -1, 0, {}})};
+        for(const int columnOffset : clause) disjunction.operands.push_back(Node{Kind::FIELD, columnOffset, 0, {}});
+    }
+    return RuleExpression{std::move(root)};
+}
+
+std::optional<std::vector<std::vector<int>>> RuleExpression::clauses() const{
+    const auto fieldsOf{[](const Node &node) -> std::optional<std::vector<int>>{
+        if(node.kind == Kind::FIELD) return std::vector<int>{node.columnOffset};
+        if(node.kind != Kind::OR) return std::nullopt;
+
+        std::vector<int> clause;
+        for(const Node &operand : node.operands){
+            if(operand.kind != Kind::FIELD) return std::nullopt;
+            clause.push_back(operand.columnOffset);
+        }
+        return clause;
+    }};
+
+    std::vector<std::vector<int>> clauseList;
+    if(empty()) return clauseList;
+    if(root_.kind == Kind::AND){
+        for(const Node &operand : root_.operands){
+            std::optional<std::vector<int>> clause{fieldsOf(operand)};
+            if(!clause.has_value()) return std::nullopt;
+            clauseList.push_back(std::move(clause.value()));
+        }
+    }else{
+        std::optional<std::vector<int>> clause{fieldsOf(root_)};
+        if(!clause.has_value()) return std::nullopt;
+        clauseList.push_back(std::move(clause.value()));
+    }
+    return clauseList;
+}
+
+std::vector<int> RuleExpression::columnOffsets() const{
+    std::vector<int> columnOffsets;
+    collectColumnOffsets(root_, columnOffsets);
+    std::sort(columnOffsets.begin(), columnOffsets.end());
+    columnOffsets.erase(std::unique(columnOffsets.begin(), columnOffsets.end()), columnOffsets.end());
+    return columnOffsets;
+}
+
+std::size_t RuleExpression::fieldReferenceCount() const{
+    std::vector<int> columnOffsets;
+    collectColumnOffsets(root_, columnOffsets);
+    return columnOffsets.size();
+}
+
+int RuleExpression::requiredColumnOffset() const{
+    return ::requiredColumnOffset(root_);
+}
+
+std::string RuleExpression::toString() const{
+    if(empty()) return {};
+    return formatNode(root_, 0);
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// A completeness rule: which cells of a row have to be valid, or invalid, for the row to count.
+//
+// Syntax: 1 based field numbers, '!' for not, '&' for and, '|' for or, parentheses, and
+// atleast(k, a, b, ...) for at least k of the operands, which may be rules themselves. '!' binds
+// tightest, then '&', then '|'; e.g. 1 & (2 | !3) & atleast(2, 4, 5, 6).
+//
+// The original combination syntax, 1:2:3/4, stands for an AND of OR groups and is built with
+// fromClauses. Rules of that shape give their groups back through clauses(), so they are shown
+// and saved the way they always were.
+class RuleExpression{
+public:
+    enum class Kind{
+        FIELD,
+        NOT,
+        AND,
+        OR,
+        AT_LEAST
+    };
+
+    struct Node{
+        Kind kind{Kind::FIELD};
+        int columnOffset{-1}; // FIELD, 0 based
+        int minimumCount{0};  // AT_LEAST
+        std::vector<Node> operands;
+
+        bool operator==(const Node &) const = default;
+    };
+
+    RuleExpression() = default; // empty, refers to no field
+    explicit RuleExpression(Node root); // nested ANDs and ORs are flattened, double negations removed
+
+    static RuleExpression parse(std::string_view text); // throws std::invalid_argument
+    static RuleExpression fromClauses(const std::vector<std::vector<int>> &clauses); // AND of OR groups of column offsets, empty for no groups
+
+    // true for rules that are not plain field lists in the original syntax
+    static bool isExpressionSyntax(std::string_view text){ return text.find_first_of("&|!()") != std::string_view::npos; }
+
+    bool empty() const{ return root_.kind == Kind::FIELD && root_.columnOffset < 0; }
+    const Node &root() const{ return root_; }
+
+    std::optional<std::vector<std::vector<int>>> clauses() const; // empty unless the rule is an AND of OR groups
+    std::vector<int> columnOffsets() const;                        // sorted, each once
+    std::size_t fieldReferenceCount() const;
+    int requiredColumnOffset() const; // rightmost column every satisfying row has a valid cell in, -1 if there is none
+
+    std::string toString() const; // in the expression syntax, with 1 based field numbers
+
+    bool operator==(const RuleExpression &) const = default;
+
+private:
+    Node root_;
+};
@@ -3,29 +3,88 @@
 #include <fmt/core.h>
 #include <fmt/ranges.h>
 
-#include <csv.h>
 #include <nlohmann/json.hpp>
 
+#include <cstdint>
+#include <filesystem>
 #include <fstream>
+#include <limits>
+#include <optional>
 
 #include "constants.hpp"
+#include "recordreader.hpp"
+
+namespace{
+
+    nlohmann::json readPartialResult(const std::string &filePath){
+        std::ifstream inputFile{filePath};
+        if(!inputFile){
+            throw std::runtime_error{fmt::format("Could not open partial result '{}'.", filePath)};
+        }
+
+        nlohmann::json root;
+        try{
+            inputFile >> root;
+        }catch(const nlohmann::json::exception &exception){
+            throw std::runtime_error{fmt::format("Failed to parse partial result '{}'. {}", filePath, exception.what())};
+        }
+
+        if(!root.is_object() || !root.contains("partial") || !root.contains("configuration")){
+            throw std::runtime_error{fmt::format("'{}' is not a partial result written with --byte-range.", filePath)};
+        }
+        return root;
+    }
+
+    std::string encodeRegisters(const HyperLogLog &sketch){
+        std::string encoded;
+        encoded.reserve(sketch.registers().size() * 2);
+        for(const std::uint8_t value : sketch.registers()) encoded += fmt::format("{:02x}", value);
+        return encoded;
+    }
+
+    HyperLogLog decodeRegisters(const std::string &encoded){
+        if(encoded.size() % 2 != 0) throw std::runtime_error{"Malformed HyperLogLog registers in partial result."};
+
+        std::vector<std::uint8_t> registers(encoded.size() / 2);
+        for(std::size_t registerIndex{0}; registerIndex < registers.size(); registerIndex++){
+            registers[registerIndex] = static_cast<std::uint8_t>(std::stoi(encoded.substr(registerIndex * 2, 2), nullptr, 16));
+        }
+        return HyperLogLog::fromRegisters(std::move(registers));
+    }
+
+} // namespace
 
 void NaNalyzer::saveInitializationToJson(const std::string &filePath) const{
     if(csvFilePath_.empty()){
         throw std::runtime_error{"No source CSV file specified. Nothing to export."};
     }
 
+    std::ofstream outputFile{filePath};
+    if(!outputFile){
+        throw std::runtime_error{fmt::format("Could not open '{}' for writing.", filePath)};
+    }
+
+    outputFile << initializationToJson().dump(4) << '\n';
+}
+
+nlohmann::json NaNalyzer::initializationToJson() const{
     nlohmann::json root;
     root["version"] = Constants::Version;
     root["csv_file"] = csvFilePath_;
     root["headers"] = headers_;
 
+    nlohmann::json dialectJson;
+    dialectJson["delimiter"] = std::string(1, dialect_.delimiter);
+    dialectJson["quote"] = dialect_.quote == '\0' ? std::string{} : std::string(1, dialect_.quote);
+    dialectJson["trim"] = dialect_.trim;
+    root["dialect"] = std::move(dialectJson);
+
     std::vector<std::pair<int, Column>> sortedColumns{columns_.begin(), columns_.end()};
     std::sort(sortedColumns.begin(), sortedColumns.end(), [](const auto &a, const auto &b){
         return a.first < b.first;
     });
 
-    nlohmann::json columnsJson{nlohmann::json::array()};
+    nlohmann::json columnsJson = nlohmann::json::array();
     for(const auto &[fieldNumber, columnDefinition] : sortedColumns){
         nlohmann::json columnJson;
         columnJson["field_number"] = fieldNumber;
@@ -35,26 +94,41 @@ void NaNalyzer::saveInitializationToJson(const std::string &filePath) const{
         std::sort(invalidValues.begin(), invalidValues.end());
         columnJson["invalid_values"] = std::move(invalidValues);
 
+        if(!columnDefinition.invalidPatterns.empty()){
+            columnJson["invalid_patterns"] = columnDefinition.invalidPatterns;
+        }
+
+        if(!columnDefinition.typeRule.empty()){
+            columnJson["type_rule"] = columnDefinition.typeRule.specification();
+        }
+
         columnsJson.push_back(std::move(columnJson));
     }
 
     root["columns"] = std::move(columnsJson);
 
-    nlohmann::json combinationsJson{nlohmann::json::array()};
+    nlohmann::json combinationsJson = nlohmann::json::array();
     for(const auto &combination : columnCombinationsToCheck_){
+        // rules beyond groups of alternatives are saved as their expression
+        const std::optional<std::vector<ColumnDisjunction>> clauses{combination.clauses()};
+        if(!clauses.has_value()){
+            combinationsJson.push_back(combination.toString());
+            continue;
+        }
+
         const bool hasDisjunction{
             std::any_of(
-                combination.begin(),
-                combination.end(),
+                clauses->begin(),
+                clauses->end(),
                 [](const ColumnDisjunction &clause){ return clause.size() > 1;}
             )
         };
 
         if(!hasDisjunction){
             std::vector<int> flattened;
-            flattened.reserve(combination.size());
+            flattened.reserve(clauses->size());
 
-            for(const ColumnDisjunction &clause : combination){
+            for(const ColumnDisjunction &clause : clauses.value()){
                 if(clause.empty()) continue;
                 flattened.push_back(clause.front() + 1);
             }
@@ -63,8 +137,8 @@ void NaNalyzer::saveInitializationToJson(const std::string &filePath) const{
             continue;
         }
 
-        nlohmann::json combinationJson{nlohmann::json::array()};
-        for(const ColumnDisjunction &clause : combination){
+        nlohmann::json combinationJson = nlohmann::json::array();
+        for(const ColumnDisjunction &clause : clauses.value()){
             std::vector<int> clauseIndices;
             clauseIndices.reserve(clause.size());
 
@@ -80,12 +154,24 @@ void NaNalyzer::saveInitializationToJson(const std::string &filePath) const{
 
     root["combinations"] = std::move(combinationsJson);
 
-    std::ofstream outputFile{filePath};
-    if(!outputFile){
-        throw std::runtime_error{fmt::format("Could not open '{}' for writing.", filePath)};
+    if(!rowFilters_.empty()){
+        nlohmann::json whereJson = nlohmann::json::array();
+        for(const RowFilter &rowFilter : rowFilters_) whereJson.push_back(rowFilter.specification());
+        root["where"] = std::move(whereJson);
     }
 
-    outputFile << root.dump(4) << '\n';
+    if(groupByColumn_.has_value()){
+        root["group_by"] = groupByColumn_.value() + 1;
+    }
+
+    if(!distinctOnColumns_.empty()){
+        nlohmann::json distinctFieldNumbers = nlohmann::json::array();
+        for(const ColumnOffset columnOffset : distinctOnColumns_) distinctFieldNumbers.push_back(columnOffset + 1);
+        root["distinct_on"] = std::move(distinctFieldNumbers);
+        root["distinct_mode"] = distinctMode_ == DistinctMode::HYPERLOGLOG ? "hll" : "exact";
+    }
+
+    return root;
 }
 
 void NaNalyzer::loadInitializationFromJson(const std::string &filePath){
@@ -106,23 +192,62 @@ void NaNalyzer::loadInitializationFromJson(const std::string &filePath){
         throw std::runtime_error{"JSON configuration is missing 'csv_file'."};
     }
 
-    io::LineReader csvLineReader{csvPath};
-    char *headerLine{nullptr};
+    applyDialectFromJson(root);
+    applyInitializationFromJson(root, readCsvHeader(csvPath));
+}
+
+NaNalyzer::HeaderList NaNalyzer::readCsvHeader(const FilePath &csvPath) const{
+    // the same reader and tokenizer as the data rows, so the header follows the same dialect
+    HeaderList headers;
+    bool hasHeader{false};
     try{
-        headerLine = csvLineReader.next_line();
+        CsvRecordReader recordReader{csvPath, {}};
+        recordReader.retainAllColumns();
+
+        RowFieldList headerFields;
+        hasHeader = visitRowTokenizer(dialect_, [&](const auto tokenizeRow){
+            return recordReader.readRecord(tokenizeRow, headerFields);
+        });
+        headers.assign(headerFields.begin(), headerFields.end());
     }catch(const std::exception &exception){
         throw std::runtime_error{fmt::format("Could not open or read file '{}'. {}", csvPath, exception.what())};
     }
 
-    if(!headerLine){
-        throw std::runtime_error{"No header line found in CSV file referenced by configuration."};
+    if(!hasHeader){
+        throw std::runtime_error{fmt::format("No header line found in CSV file '{}'.", csvPath)};
+    }
+
+    if(headers.size() == 1 && headers.front().empty()) headers.clear(); // an empty first line
+    if(headers.empty()){
+        throw std::runtime_error{fmt::format("CSV file '{}' does not contain any headers.", csvPath)};
     }
+    return headers;
+}
+
+void NaNalyzer::applyDialectFromJson(const nlohmann::json &root){
+    if(root.contains("dialect") && !dialectSetFromCli_){
+        const nlohmann::json &dialectJson{root["dialect"]};
+        CsvDialect dialect;
+
+        const std::string delimiter{dialectJson.value("delimiter", std::string(1, dialect.delimiter))};
+        if(delimiter.size() != 1){
+            throw std::runtime_error{fmt::format("Dialect delimiter '{}' must be a single character.", delimiter)};
+        }
+        dialect.delimiter = delimiter.front();
+
+        const std::string quote{dialectJson.value("quote", std::string{})};
+        if(quote.size() > 1){
+            throw std::runtime_error{fmt::format("Dialect quote '{}' must be a single character or empty.", quote)};
+        }
+        dialect.quote = quote.empty() ? '\0' : quote.front();
+        dialect.trim = dialectJson.value("trim", dialect.trim);
 
-    HeaderList actualHeaders{splitString(std::string{headerLine}, ',')};
-    if(actualHeaders.empty()){
-        throw std::runtime_error{"CSV file referenced by configuration does not contain any headers."};
+        visitRowTokenizer(dialect, [](auto){}); // rejects dialects without a compiled tokenizer
+        dialect_ = dialect;
     }
+}
 
+void NaNalyzer::applyInitializationFromJson(const nlohmann::json &root, HeaderList actualHeaders){
     if(root.contains("headers")){
         const HeaderList headersFromJson{root["headers"].get<HeaderList>()};
         if(!headersFromJson.empty() && headersFromJson != actualHeaders){
@@ -130,7 +255,7 @@ void NaNalyzer::loadInitializationFromJson(const std::string &filePath){
         }
     }
 
-    csvFilePath_ = csvPath;
+    csvFilePath_ = root.at("csv_file").get<std::string>();
     headers_ = std::move(actualHeaders);
 
     columns_.clear();
@@ -153,6 +278,15 @@ void NaNalyzer::loadInitializationFromJson(const std::string &filePath){
             }
             columnDefinition.invalidValues = InvalidValueSet{invalidValues.begin(), invalidValues.end()};
 
+            if(columnJson.contains("invalid_patterns")){
+                columnDefinition.invalidPatterns = columnJson["invalid_patterns"].get<DelimitedStringList>();
+                columnDefinition.invalidPatternMatcher = PatternMatcher{columnDefinition.invalidPatterns};
+            }
+
+            if(columnJson.contains("type_rule")){
+                columnDefinition.typeRule = TypeRule{columnJson["type_rule"].get<std::string>()};
+            }
+
             columns_.emplace(fieldNumber, std::move(columnDefinition));
         }
     }
@@ -160,9 +294,13 @@ void NaNalyzer::loadInitializationFromJson(const std::string &filePath){
     columnCombinationsToCheck_.clear();
     if(root.contains("combinations")){
         for(const auto &combinationJson : root["combinations"]){
+            if(combinationJson.is_string()){
+                columnCombinationsToCheck_.push_back(parseCombinationString(combinationJson.get<std::string>()));
+                continue;
+            }
             if(!combinationJson.is_array()) continue;
 
-            ColumnCombination combination;
+            std::vector<ColumnDisjunction> clauses;
 
             const bool isLegacyFormat{
                 std::all_of(
@@ -173,7 +311,7 @@ void NaNalyzer::loadInitializationFromJson(const std::string &filePath){
             };
 
             if(isLegacyFormat){
-                combination.reserve(combinationJson.size());
+                clauses.reserve(combinationJson.size());
 
                 for(const auto &value : combinationJson){
                     int fieldNumber{value.get<int>()};
@@ -189,10 +327,10 @@ void NaNalyzer::loadInitializationFromJson(const std::string &filePath){
 
                     ColumnDisjunction clause;
                     clause.push_back(zeroBasedIndex);
-                    combination.push_back(std::move(clause));
+                    clauses.push_back(std::move(clause));
                 }
             }else{
-                combination.reserve(combinationJson.size());
+                clauses.reserve(combinationJson.size());
 
                 for(const auto &clauseJson : combinationJson){
                     ColumnDisjunction clause;
@@ -239,15 +377,476 @@ void NaNalyzer::loadInitializationFromJson(const std::string &filePath){
 
                     std::sort(clause.begin(), clause.end());
                     clause.erase(std::unique(clause.begin(), clause.end()), clause.end());
-                    combination.push_back(std::move(clause));
+                    clauses.push_back(std::move(clause));
                 }
             }
 
-            if(!combination.empty()){
-                columnCombinationsToCheck_.push_back(std::move(combination));
+            if(!clauses.empty()){
+                columnCombinationsToCheck_.push_back(RuleExpression::fromClauses(clauses));
             }
         }
     }
 
+    rowFilters_.clear();
+    if(root.contains("where")){
+        for(const auto &whereJson : root["where"]){
+            rowFilters_.emplace_back(whereJson.get<std::string>(), headers_);
+        }
+    }
+
+    groupByColumn_.reset();
+    if(root.contains("group_by") && !root["group_by"].is_null()){
+        const int fieldNumber{root["group_by"].get<int>()};
+        if(fieldNumber < 1 || fieldNumber > static_cast<int>(headers_.size())){
+            throw std::runtime_error{fmt::format("Field number {} in group_by is out of range.", fieldNumber)};
+        }
+        groupByColumn_ = fieldNumber - 1;
+    }
+
+    distinctOnColumns_.clear();
+    if(root.contains("distinct_on") && root["distinct_on"].is_array()){
+        for(const auto &fieldNumberJson : root["distinct_on"]){
+            const int fieldNumber{fieldNumberJson.get<int>()};
+            if(fieldNumber < 1 || fieldNumber > static_cast<int>(headers_.size())){
+                throw std::runtime_error{fmt::format("Field number {} in distinct_on is out of range.", fieldNumber)};
+            }
+            distinctOnColumns_.push_back(fieldNumber - 1);
+        }
+    }
+    distinctMode_ = root.value("distinct_mode", std::string{"exact"}) == "hll" ? DistinctMode::HYPERLOGLOG : DistinctMode::EXACT;
+
     configurationLoadedFromJson_ = true;
 }
+
+void NaNalyzer::saveFailedRowsToJson(const std::string &filePath) const{
+    nlohmann::json root;
+    root["version"] = Constants::Version;
+    root["csv_file"] = csvFilePath_;
+
+    nlohmann::json combinationsJson = nlohmann::json::array();
+    for(std::size_t combinationIndex{0}; combinationIndex < columnCombinationsToCheck_.size(); combinationIndex++){
+        const FailedRowRangeList &failedRanges{failedRowRanges_[combinationIndex]};
+
+        long long int failedRowCount{0};
+        nlohmann::json rangesJson = nlohmann::json::array();
+        for(const FailedRowRange &range : failedRanges){
+            failedRowCount += range.lastRow - range.firstRow + 1;
+            rangesJson.push_back({range.firstRow, range.lastRow, range.firstByte, range.endByte});
+        }
+
+        nlohmann::json combinationJson;
+        combinationJson["combination"] = formatCombinationForDisplay(columnCombinationsToCheck_[combinationIndex]);
+        combinationJson["failed_rows"] = failedRowCount;
+        combinationJson["ranges"] = std::move(rangesJson); // [first_row, last_row, first_byte, end_byte)
+
+        combinationsJson.push_back(std::move(combinationJson));
+    }
+    root["combinations"] = std::move(combinationsJson);
+
+    std::ofstream outputFile{filePath};
+    if(!outputFile){
+        throw std::runtime_error{fmt::format("Could not open '{}' for writing.", filePath)};
+    }
+
+    outputFile << root.dump() << '\n';
+}
+
+void NaNalyzer::writeMetricsTextfile(const std::string &metrics) const{
+    // node-exporter may read the file at any moment, so write a sibling it ignores and rename it into place
+    const FilePath temporaryPath{metricsTextfilePath_.value() + ".tmp"};
+    {
+        std::ofstream outputFile{temporaryPath, std::ios::trunc};
+        if(!outputFile){
+            throw std::runtime_error{fmt::format("Could not open '{}' for writing.", temporaryPath)};
+        }
+
+        outputFile << metrics << '\n';
+        if(!outputFile.flush()){
+            throw std::runtime_error{fmt::format("Could not write '{}'.", temporaryPath)};
+        }
+    }
+
+    std::error_code renameError;
+    std::filesystem::rename(temporaryPath, metricsTextfilePath_.value(), renameError);
+    if(renameError){
+        throw std::runtime_error{fmt::format("Could not replace '{}'. {}", metricsTextfilePath_.value(), renameError.message())};
+    }
+}
+
+std::string NaNalyzer::partialConfigurationHash() const{
+    // the path may differ between machines mounting the same storage, so it is left out
+    nlohmann::json configuration = initializationToJson();
+    configuration.erase("csv_file");
+    return fmt::format("{:016x}", HyperLogLog::hash(configuration.dump()));
+}
+
+std::string NaNalyzer::formatResultsAsPartialJson(long long int totalRowCount) const{
+    const long long int fileSize{scanTelemetry_.fileBytes};
+    const long long int dataOffset{scanTelemetry_.dataOffset};
+
+    nlohmann::json partialJson;
+    partialJson["config_hash"] = partialConfigurationHash();
+    partialJson["file_size"] = fileSize;
+    partialJson["modified_time"] = ColumnarCache::stampFile(csvFilePath_, dialect_).modifiedTime;
+    partialJson["data_offset"] = dataOffset;
+    // clamped to the data rows, so the shards of one scan tile [data_offset, file_size) exactly
+    partialJson["byte_range"] = {
+        std::clamp(byteRange_->begin, dataOffset, fileSize),
+        std::clamp(byteRange_->end, dataOffset, fileSize)
+    };
+    partialJson["duration_seconds"] = scanTelemetry_.durationSeconds;
+
+    nlohmann::json root;
+    root["version"] = Constants::Version;
+    root["partial"] = std::move(partialJson);
+    root["configuration"] = initializationToJson();
+    root["total_rows"] = totalRowCount;
+    root["valid_counts"] = validCounts_;
+
+    if(groupByColumn_.has_value()){
+        const std::size_t combinationCount{columnCombinationsToCheck_.size()};
+
+        nlohmann::json groupsArray = nlohmann::json::array();
+        for(std::size_t groupIndex{0}; groupIndex < groupKeys_.size(); groupIndex++){
+            const auto groupValidCounts{groupValidCounts_.begin() + static_cast<std::ptrdiff_t>(groupIndex * combinationCount)};
+
+            nlohmann::json groupObject;
+            groupObject["key"] = std::string{groupKeys_[groupIndex]};
+            groupObject["total_rows"] = groupRowCounts_[groupIndex];
+            groupObject["valid_counts"] = std::vector<long long int>(groupValidCounts, groupValidCounts + static_cast<std::ptrdiff_t>(combinationCount));
+            groupsArray.push_back(std::move(groupObject));
+        }
+        root["groups"] = std::move(groupsArray);
+    }
+
+    if(!distinctOnColumns_.empty()){ // sketches merge by register maxima, exact entity sets would not fit a partial
+        nlohmann::json validSketches = nlohmann::json::array();
+        for(const HyperLogLog &sketch : distinctValidSketches_) validSketches.push_back(encodeRegisters(sketch));
+
+        nlohmann::json distinctJson;
+        distinctJson["entities"] = encodeRegisters(distinctEntitySketch_);
+        distinctJson["valid"] = std::move(validSketches);
+        root["distinct"] = std::move(distinctJson);
+    }
+
+    if(!valueProfiles_.empty()){
+        nlohmann::json profilesArray = nlohmann::json::array();
+        for(const ValueProfile &valueProfile : valueProfiles_){
+            nlohmann::json entriesArray = nlohmann::json::array();
+            for(const TopKSketch::Entry &entry : valueProfile.sketch.entries()){
+                entriesArray.push_back({entry.value, entry.count, entry.overcount});
+            }
+
+            nlohmann::json profileObject;
+            profileObject["field_number"] = valueProfile.fieldNumber;
+            profileObject["capacity"] = valueProfile.sketch.capacity();
+            profileObject["total_rows"] = valueProfile.sketch.totalWeight();
+            profileObject["entries"] = std::move(entriesArray);
+            profileObject["frequency_cells"] = valueProfile.sketch.frequencyCells();
+            profilesArray.push_back(std::move(profileObject));
+        }
+        root["value_profiles"] = std::move(profilesArray);
+    }
+
+    return root.dump();
+}
+
+void NaNalyzer::loadPartialConfiguration(const std::string &partialFilePath){
+    const nlohmann::json root = readPartialResult(partialFilePath);
+    const nlohmann::json &configuration{root["configuration"]};
+
+    applyDialectFromJson(configuration);
+    applyInitializationFromJson(configuration, configuration.at("headers").get<HeaderList>());
+
+    if(!distinctOnColumns_.empty() && distinctMode_ != DistinctMode::HYPERLOGLOG){
+        throw std::runtime_error{"Partial results carry distinct entities only as HyperLogLog sketches."};
+    }
+}
+
+void NaNalyzer::mergePartialResults(const std::vector<std::string> &partialFilePaths){
+    const long long int totalRowCount{loadPartialResults(partialFilePaths)};
+
+    if(metricsTextfilePath_.has_value()){
+        writeMetricsTextfile(formatResultsAsOpenMetrics(totalRowCount));
+        if(!silentMode_) fmt::println("Saved metrics to '{}'.", metricsTextfilePath_.value());
+    }
+
+    if(valueProfilePath_.has_value()){
+        saveValueProfiles(valueProfilePath_.value());
+        if(!silentMode_) fmt::println("Saved value profiles and suggested invalid values to '{}'.", valueProfilePath_.value());
+    }
+
+    if(!silentMode_) fmt::println("\nMerged {} partial results.", partialFilePaths.size());
+    reportResults(totalRowCount);
+}
+
+long long int NaNalyzer::loadPartialResults(const std::vector<FilePath> &partialFilePaths){
+    const std::size_t combinationCount{columnCombinationsToCheck_.size()};
+    const std::string expectedHash{partialConfigurationHash()};
+
+    resetResults();
+
+    long long int totalRowCount{0};
+    long long int fileSize{-1};
+    std::optional<std::int64_t> modifiedTime;
+    long long int dataOffset{0};
+    double longestDuration{0.0};
+    std::vector<ByteRange> byteRanges;
+
+    const auto readCounts{[combinationCount](const nlohmann::json &countsJson, const std::string &filePath){
+        std::vector<long long int> counts{countsJson.get<std::vector<long long int>>()};
+        if(counts.size() != combinationCount){
+            throw std::runtime_error{fmt::format("Partial result '{}' has {} combination counts instead of {}.", filePath, counts.size(), combinationCount)};
+        }
+        return counts;
+    }};
+
+    for(const std::string &partialFilePath : partialFilePaths){
+        const nlohmann::json root = readPartialResult(partialFilePath);
+        const nlohmann::json &partialJson{root["partial"]};
+
+        if(partialJson.at("config_hash").get<std::string>() != expectedHash){
+            throw std::runtime_error{fmt::format(
+                "Partial result '{}' was made with a different configuration than '{}'.",
+                partialFilePath,
+                partialFilePaths.front()
+            )};
+        }
+
+        const long long int partialFileSize{partialJson.at("file_size").get<long long int>()};
+        if(fileSize >= 0 && partialFileSize != fileSize){
+            throw std::runtime_error{fmt::format(
+                "Partial result '{}' was made from a {} byte file, '{}' from a {} byte one.",
+                partialFilePath,
+                partialFileSize,
+                partialFilePaths.front(),
+                fileSize
+            )};
+        }
+        fileSize = partialFileSize;
+
+        const std::int64_t partialModifiedTime{partialJson.at("modified_time").get<std::int64_t>()};
+        if(modifiedTime.has_value() && partialModifiedTime != *modifiedTime){
+            throw std::runtime_error{fmt::format(
+                "Partial result '{}' was made from a different version of the file than '{}', it was modified in between.",
+                partialFilePath,
+                partialFilePaths.front()
+            )};
+        }
+        modifiedTime = partialModifiedTime;
+        dataOffset = partialJson.at("data_offset").get<long long int>();
+        longestDuration = std::max(longestDuration, partialJson.value("duration_seconds", 0.0));
+
+        const nlohmann::json &byteRangeJson{partialJson.at("byte_range")};
+        byteRanges.push_back({byteRangeJson.at(0).get<long long int>(), byteRangeJson.at(1).get<long long int>()});
+
+        totalRowCount += root.at("total_rows").get<long long int>();
+        const std::vector<long long int> validCounts{readCounts(root.at("valid_counts"), partialFilePath)};
+        for(std::size_t combinationIndex{0}; combinationIndex < combinationCount; combinationIndex++){
+            validCounts_[combinationIndex] += validCounts[combinationIndex];
+        }
+
+        if(root.contains("groups")){
+            for(const nlohmann::json &groupObject : root["groups"]){
+                const std::size_t groupIndex{internGroupKey(groupObject.at("key").get<std::string>())};
+                groupRowCounts_[groupIndex] += groupObject.at("total_rows").get<long long int>();
+
+                const std::vector<long long int> groupValidCounts{readCounts(groupObject.at("valid_counts"), partialFilePath)};
+                for(std::size_t combinationIndex{0}; combinationIndex < combinationCount; combinationIndex++){
+                    groupValidCounts_[groupIndex * combinationCount + combinationIndex] += groupValidCounts[combinationIndex];
+                }
+            }
+        }
+
+        if(!distinctOnColumns_.empty()){
+            const nlohmann::json &distinctJson{root.at("distinct")};
+            distinctEntitySketch_.merge(decodeRegisters(distinctJson.at("entities").get<std::string>()));
+
+            const nlohmann::json &validSketches{distinctJson.at("valid")};
+            if(validSketches.size() != combinationCount){
+                throw std::runtime_error{fmt::format("Partial result '{}' has {} distinct sketches instead of {}.", partialFilePath, validSketches.size(), combinationCount)};
+            }
+            for(std::size_t combinationIndex{0}; combinationIndex < combinationCount; combinationIndex++){
+                distinctValidSketches_[combinationIndex].merge(decodeRegisters(validSketches[combinationIndex].get<std::string>()));
+            }
+        }
+
+        if(!valueProfiles_.empty()){
+            if(!root.contains("value_profiles")){
+                throw std::runtime_error{fmt::format("Partial result '{}' has no value profiles, scan every shard with --profile-values.", partialFilePath)};
+            }
+
+            for(const nlohmann::json &profileObject : root["value_profiles"]){
+                const int fieldNumber{profileObject.at("field_number").get<int>()};
+                const auto valueProfile{std::find_if(valueProfiles_.begin(), valueProfiles_.end(), [fieldNumber](const ValueProfile &candidate){
+                    return candidate.fieldNumber == fieldNumber;
+                })};
+                if(valueProfile == valueProfiles_.end()) continue;
+
+                std::vector<TopKSketch::Entry> entries;
+                for(const nlohmann::json &entryJson : profileObject.at("entries")){
+                    entries.push_back({entryJson.at(0).get<std::string>(), entryJson.at(1).get<long long int>(), entryJson.at(2).get<long long int>()});
+                }
+                valueProfile->sketch.merge(TopKSketch::fromState(
+                    profileObject.at("capacity").get<std::size_t>(),
+                    profileObject.at("total_rows").get<long long int>(),
+                    entries,
+                    profileObject.at("frequency_cells").get<std::vector<long long int>>()
+                ));
+            }
+        }
+    }
+
+    // the shards have to tile the data rows: an overlap would count rows twice, a gap leaves them out
+    std::sort(byteRanges.begin(), byteRanges.end(), [](const ByteRange &left, const ByteRange &right){
+        return left.begin < right.begin;
+    });
+
+    long long int coveredUntil{dataOffset};
+    for(const ByteRange &byteRange : byteRanges){
+        if(byteRange.begin < coveredUntil){
+            throw std::runtime_error{fmt::format("Partial results overlap in bytes {}..{}, their rows would be counted twice.", byteRange.begin, coveredUntil)};
+        }
+        if(byteRange.begin > coveredUntil){
+            fmt::println(stderr, "Warning: no partial result covers bytes {}..{}, the rows starting there are missing.", coveredUntil, byteRange.begin);
+        }
+        coveredUntil = std::max(coveredUntil, byteRange.end);
+    }
+    if(coveredUntil < fileSize){
+        fmt::println(stderr, "Warning: no partial result covers bytes {}..{}, the rows starting there are missing.", coveredUntil, fileSize);
+    }
+
+    scanTelemetry_ = ScanTelemetry{longestDuration, fileSize, fileSize, static_cast<int>(partialFilePaths.size()), totalRowCount, dataOffset, {}, 0.0};
+
+    concludeQualityGates(totalRowCount);
+    if(!distinctOnColumns_.empty()) concludeDistinctCounts();
+
+    return totalRowCount;
+}
+
+std::unique_ptr<NaNalyzer> NaNalyzer::makeBaselineAnalyzer() const{
+    // the comparison is per combination, groups and distinct entities would only slow the baseline down
+    nlohmann::json configuration = initializationToJson();
+    configuration["csv_file"] = baselineFilePath_.value();
+    configuration.erase("group_by");
+    configuration.erase("distinct_on");
+    configuration.erase("distinct_mode");
+
+    auto baselineAnalyzer{std::make_unique<NaNalyzer>()};
+    baselineAnalyzer->silentMode_ = true;
+    baselineAnalyzer->dialect_ = dialect_;
+    baselineAnalyzer->dialectSetFromCli_ = true;
+    baselineAnalyzer->directIo_ = directIo_;
+    baselineAnalyzer->scanThrottle_ = scanThrottle_;
+
+    HeaderList baselineHeaders;
+    try{
+        baselineHeaders = baselineAnalyzer->readCsvHeader(baselineFilePath_.value());
+    }catch(const std::exception &exception){
+        throw std::runtime_error{fmt::format("Could not read baseline '{}'. {}", baselineFilePath_.value(), exception.what())};
+    }
+    if(baselineHeaders != headers_){
+        throw std::runtime_error{fmt::format("Baseline '{}' does not have the same headers as '{}'.", baselineFilePath_.value(), csvFilePath_)};
+    }
+    baselineAnalyzer->applyInitializationFromJson(configuration, std::move(baselineHeaders));
+
+    // a whole file range, so the result can be saved and reloaded in the partial result format
+    baselineAnalyzer->byteRange_ = ByteRange{0, std::numeric_limits<long long int>::max()};
+    return baselineAnalyzer;
+}
+
+NaNalyzer::FilePath NaNalyzer::deriveBaselineResultPath(const FilePath &baselineFilePath){
+    return baselineFilePath + ".completeness.json";
+}
+
+NaNalyzer::FilePath NaNalyzer::deriveValueProfilePath(const FilePath &csvFilePath){
+    return csvFilePath + ".profile.json";
+}
+
+nlohmann::json NaNalyzer::valueProfilesToJson() const{
+    nlohmann::json profilesArray = nlohmann::json::array();
+    for(const ValueProfile &valueProfile : valueProfiles_){
+        const std::vector<std::string> suggestions{suggestInvalidValues(valueProfile)};
+        const long long int rowCount{valueProfile.sketch.totalWeight()};
+
+        nlohmann::json valuesArray = nlohmann::json::array();
+        const std::vector<TopKSketch::Entry> entries{valueProfile.sketch.entries()};
+        for(std::size_t entryIndex{0}; entryIndex < std::min(entries.size(), Constants::ValueProfileReportCount); entryIndex++){
+            const TopKSketch::Entry &entry{entries[entryIndex]};
+
+            nlohmann::json valueObject;
+            valueObject["value"] = entry.value;
+            valueObject["count"] = entry.count;
+            valueObject["overcount"] = entry.overcount;
+            valueObject["share"] = rowCount > 0 ? static_cast<double>(entry.count) / static_cast<double>(rowCount) : 0.0;
+            valueObject["suggested"] = std::find(suggestions.begin(), suggestions.end(), entry.value) != suggestions.end();
+            valuesArray.push_back(std::move(valueObject));
+        }
+
+        nlohmann::json profileObject;
+        profileObject["field_number"] = valueProfile.fieldNumber;
+        profileObject["name"] = columns_.at(valueProfile.fieldNumber).name;
+        profileObject["total_rows"] = rowCount;
+        profileObject["values"] = std::move(valuesArray);
+        profileObject["suggested_invalid_values"] = suggestions;
+        profilesArray.push_back(std::move(profileObject));
+    }
+    return profilesArray;
+}
+
+void NaNalyzer::saveValueProfiles(const FilePath &filePath) const{
+    // a configuration as saveInitializationToJson writes it, with the suggestions already added to
+    // the invalid values; the profiles ride along for review and are ignored when it is loaded
+    nlohmann::json root = initializationToJson();
+    for(nlohmann::json &columnJson : root["columns"]){
+        const int fieldNumber{columnJson.at("field_number").get<int>()};
+        const auto valueProfile{std::find_if(valueProfiles_.begin(), valueProfiles_.end(), [fieldNumber](const ValueProfile &candidate){
+            return candidate.fieldNumber == fieldNumber;
+        })};
+        if(valueProfile == valueProfiles_.end()) continue;
+
+        DelimitedStringList invalidValues{columnJson["invalid_values"].get<DelimitedStringList>()};
+        for(std::string &suggestion : suggestInvalidValues(*valueProfile)) invalidValues.push_back(std::move(suggestion));
+        std::sort(invalidValues.begin(), invalidValues.end());
+        columnJson["invalid_values"] = std::move(invalidValues);
+    }
+    root["value_profiles"] = valueProfilesToJson();
+
+    std::ofstream outputFile{filePath};
+    if(!outputFile){
+        throw std::runtime_error{fmt::format("Could not open '{}' for writing.", filePath)};
+    }
+    outputFile << root.dump(4) << '\n';
+}
+
+bool NaNalyzer::loadCachedBaselineResult(const FilePath &resultFilePath){
+    std::error_code resultFileError;
+    if(!std::filesystem::exists(resultFilePath, resultFileError)) return false;
+
+    try{
+        const nlohmann::json root = readPartialResult(resultFilePath);
+        const nlohmann::json &partialJson{root["partial"]};
+
+        const ColumnarCache::SourceStamp sourceStamp{ColumnarCache::stampFile(csvFilePath_, dialect_)};
+        if(
+            partialJson.value("file_size", -1LL) != static_cast<long long int>(sourceStamp.fileSize)
+            || partialJson.value("modified_time", std::int64_t{0}) != sourceStamp.modifiedTime
+        ){
+            return false;
+        }
+
+        loadPartialResults({resultFilePath}); // also checks the configuration
+        return true;
+    }catch(const std::exception &){
+        return false; // unreadable or made with another configuration, the scan replaces it
+    }
+}
+
+void NaNalyzer::saveBaselineResult(const FilePath &resultFilePath, long long int totalRowCount) const{
+    std::ofstream outputFile{resultFilePath};
+    if(!outputFile){
+        throw std::runtime_error{fmt::format("Could not open '{}' for writing.", resultFilePath)};
+    }
+
+    outputFile << formatResultsAsPartialJson(totalRowCount) << '\n';
+}
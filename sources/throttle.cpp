@@ -0,0 +1,115 @@
+#include "throttle.hpp"
+
+#include <fmt/core.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <ctime>
+#include <stdexcept>
+#include <thread>
+
+#if defined(__linux__)
+    #include <sys/resource.h>
+    #include <sys/syscall.h>
+    #include <unistd.h>
+#endif
+
+#include "constants.hpp"
+
+ScanThrottle::ScanThrottle(std::optional<double> maxBytesPerSecond, std::optional<double> cpuBudget)
+    : maxBytesPerSecond_{maxBytesPerSecond}
+    , cpuBudget_{cpuBudget}
+    , lastRefill_{std::chrono::steady_clock::now()}
+    , byteTokens_{maxBytesPerSecond.value_or(0.0) * std::chrono::duration<double>(Constants::ThrottleBurstDuration).count()}
+    , cpuTokens_{cpuBudget.value_or(0.0) * std::chrono::duration<double>(Constants::ThrottleBurstDuration).count()}
+    , lastCpuSeconds_{processCpuSeconds()}
+{
+    if(maxBytesPerSecond_.has_value() && !(maxBytesPerSecond_.value() > 0.0)){
+        throw std::invalid_argument{"The maximum read rate must be positive."};
+    }
+    if(cpuBudget_.has_value() && !(cpuBudget_.value() > 0.0)){
+        throw std::invalid_argument{"The CPU budget must be positive."};
+    }
+}
+
+void ScanThrottle::charge(std::size_t byteCount){
+    double waitSeconds{0.0};
+    {
+        const std::lock_guard lock{mutex_};
+
+        const auto now{std::chrono::steady_clock::now()};
+        const double elapsedSeconds{std::chrono::duration<double>(now - lastRefill_).count()};
+        const double burstSeconds{std::chrono::duration<double>(Constants::ThrottleBurstDuration).count()};
+        lastRefill_ = now;
+
+        if(maxBytesPerSecond_.has_value()){
+            const double rate{maxBytesPerSecond_.value()};
+            byteTokens_ = std::min(byteTokens_ + elapsedSeconds * rate, burstSeconds * rate) - static_cast<double>(byteCount);
+            if(byteTokens_ < 0.0) waitSeconds = std::max(waitSeconds, -byteTokens_ / rate);
+        }
+
+        if(cpuBudget_.has_value()){
+            const double budget{cpuBudget_.value()};
+            const double cpuSeconds{processCpuSeconds()};
+            cpuTokens_ = std::min(cpuTokens_ + elapsedSeconds * budget, burstSeconds * budget) - (cpuSeconds - lastCpuSeconds_);
+            lastCpuSeconds_ = cpuSeconds;
+            if(cpuTokens_ < 0.0) waitSeconds = std::max(waitSeconds, -cpuTokens_ / budget);
+        }
+
+        throttledSeconds_ += waitSeconds;
+    }
+
+    // the sleep refills both buckets by the next charge, which is how the debt gets paid
+    if(waitSeconds > 0.0) std::this_thread::sleep_for(std::chrono::duration<double>(waitSeconds));
+}
+
+double ScanThrottle::throttledSeconds() const{
+    const std::lock_guard lock{mutex_};
+    return throttledSeconds_;
+}
+
+double ScanThrottle::processCpuSeconds(){
+#if defined(__linux__)
+    timespec cpuTime{};
+    if(::clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &cpuTime) != 0) return 0.0;
+    return static_cast<double>(cpuTime.tv_sec) + static_cast<double>(cpuTime.tv_nsec) / 1e9;
+#else
+    return static_cast<double>(std::clock()) / CLOCKS_PER_SEC;
+#endif
+}
+
+#if defined(__linux__)
+
+void ScanThrottle::setNiceness(int niceness){
+    // Linux keeps the nice value per thread, the process id 0 means the calling one
+    if(::setpriority(PRIO_PROCESS, 0, niceness) != 0){
+        throw std::runtime_error{fmt::format("Could not set the nice value to {}. {}", niceness, std::strerror(errno))};
+    }
+}
+
+void ScanThrottle::setIoPriority(IoPriorityClass priorityClass, int level){
+    // from linux/ioprio.h, which older kernel headers lack
+    constexpr int IoPriorityWhoProcess{1};
+    constexpr int IoPriorityClassShift{13};
+    constexpr int IoPriorityClassBestEffort{2};
+    constexpr int IoPriorityClassIdle{3};
+
+    const int classValue{priorityClass == IoPriorityClass::IDLE ? IoPriorityClassIdle : IoPriorityClassBestEffort};
+    const int priorityValue{(classValue << IoPriorityClassShift) | (priorityClass == IoPriorityClass::IDLE ? 0 : level)};
+    if(::syscall(SYS_ioprio_set, IoPriorityWhoProcess, 0, priorityValue) != 0){
+        throw std::runtime_error{fmt::format("Could not set the I/O priority. {}", std::strerror(errno))};
+    }
+}
+
+#else
+
+void ScanThrottle::setNiceness(int){
+    throw std::runtime_error{"--nice is only available on Linux."};
+}
+
+void ScanThrottle::setIoPriority(IoPriorityClass, int){
+    throw std::runtime_error{"--io-priority is only available on Linux."};
+}
+
+#endif
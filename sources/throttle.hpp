@@ -0,0 +1,55 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <mutex>
+#include <optional>
+
+// Caps how fast a scan reads and how much CPU time it takes, so it can run next to
+// latency-sensitive services.
+//
+// Both caps are token buckets refilled with wall time: read bytes at the maximum rate, CPU
+// seconds at the budget (0.5 is half of one core). Readers charge every block they read; a
+// bucket that runs into debt makes the charging thread sleep until it is paid back. The CPU
+// time is the whole process's, so work done on other threads counts against the budget too.
+// Each bucket holds at most ThrottleBurstDuration of refill, a scan that was idle does not
+// catch up in one burst.
+//
+// One throttle may be shared by several readers, e.g. of a file and its baseline.
+class ScanThrottle{
+public:
+    enum class IoPriorityClass{
+        BEST_EFFORT, // levels 0 (highest) to 7
+        IDLE         // only served when no other process wants the disk
+    };
+
+    ScanThrottle(std::optional<double> maxBytesPerSecond, std::optional<double> cpuBudget);
+
+    ScanThrottle(const ScanThrottle &) = delete;
+    ScanThrottle &operator=(const ScanThrottle &) = delete;
+
+    void charge(std::size_t byteCount); // may sleep
+
+    std::optional<double> maxBytesPerSecond() const{ return maxBytesPerSecond_; }
+    std::optional<double> cpuBudget() const{ return cpuBudget_; }
+    double throttledSeconds() const; // slept so far
+
+    // Apply to the calling thread and every thread it starts afterwards. Linux only, other
+    // systems throw.
+    static void setNiceness(int niceness);
+    static void setIoPriority(IoPriorityClass priorityClass, int level);
+
+private:
+    static double processCpuSeconds();
+
+private:
+    std::optional<double> maxBytesPerSecond_;
+    std::optional<double> cpuBudget_;
+
+    mutable std::mutex mutex_;
+    std::chrono::steady_clock::time_point lastRefill_;
+    double byteTokens_;
+    double cpuTokens_;
+    double lastCpuSeconds_;
+    double throttledSeconds_{0.0};
+};
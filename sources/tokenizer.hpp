@@ -0,0 +1,59 @@
+#pragma once
+
+#include <stdexcept>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include <fmt/core.h>
+
+struct CsvDialect{
+    char delimiter{','};
+    char quote{'\0'}; // '\0' disables quoting
+    bool trim{true};  // strip surrounding spaces, tabs and carriage returns from unquoted fields
+};
+
+using RowFieldList = std::vector<std::string_view>;
+
+// The compile-time form of a CsvDialect. It carries no state: CsvRecordReader::readRecord is
+// instantiated per tokenizer type, so the delimiter, quote and trimming checks compile down to
+// constants and the plain comma path carries no extra branches.
+template<char Delimiter, char Quote, bool Trim>
+struct RowTokenizer{
+    // what trimming strips from both ends of an unquoted field; a line feed ends the record instead
+    static constexpr bool isTrimmable(const char character){
+        return (character == ' ' || character == '\t' || character == '\r') && character != Delimiter;
+    }
+};
+
+namespace detail{
+
+    template<char Delimiter, char Quote, typename Visitor>
+    decltype(auto) visitRowTokenizer(const bool trim, Visitor &&visitor){
+        if(trim) return std::forward<Visitor>(visitor)(RowTokenizer<Delimiter, Quote, true>{});
+        return std::forward<Visitor>(visitor)(RowTokenizer<Delimiter, Quote, false>{});
+    }
+
+    template<char Delimiter, typename Visitor>
+    decltype(auto) visitRowTokenizer(const CsvDialect &dialect, Visitor &&visitor){
+        switch(dialect.quote){
+            case '\0': return visitRowTokenizer<Delimiter, '\0'>(dialect.trim, std::forward<Visitor>(visitor));
+            case '"':  return visitRowTokenizer<Delimiter, '"'>(dialect.trim, std::forward<Visitor>(visitor));
+            case '\'': return visitRowTokenizer<Delimiter, '\''>(dialect.trim, std::forward<Visitor>(visitor));
+            default: throw std::invalid_argument{fmt::format("Unsupported quote character '{}'.", dialect.quote)};
+        }
+    }
+
+} // namespace detail
+
+// Resolves the runtime dialect to its compiled tokenizer once and hands it to the visitor.
+template<typename Visitor>
+decltype(auto) visitRowTokenizer(const CsvDialect &dialect, Visitor &&visitor){
+    switch(dialect.delimiter){
+        case ',':  return detail::visitRowTokenizer<','>(dialect, std::forward<Visitor>(visitor));
+        case '\t': return detail::visitRowTokenizer<'\t'>(dialect, std::forward<Visitor>(visitor));
+        case ';':  return detail::visitRowTokenizer<';'>(dialect, std::forward<Visitor>(visitor));
+        case '|':  return detail::visitRowTokenizer<'|'>(dialect, std::forward<Visitor>(visitor));
+        default: throw std::invalid_argument{fmt::format("Unsupported delimiter '{}'.", dialect.delimiter)};
+    }
+}
@@ -0,0 +1,232 @@
+#include "topksketch.hpp"
+
+#include <fmt/core.h>
+
+#include <algorithm>
+#include <bit>
+#include <limits>
+#include <stdexcept>
+#include <unordered_map>
+
+#include "hyperloglog.hpp"
+
+TopKSketch::TopKSketch(std::size_t capacity)
+    : capacity_{capacity}
+    , frequencyCells_(Constants::ValueProfileSketchWidth * Constants::ValueProfileSketchDepth, 0)
+{
+    static_assert(std::has_single_bit(Constants::ValueProfileSketchWidth), "The sketch width must be a power of two.");
+
+    if(capacity_ < 1 || capacity_ >= EmptySlot / 2){
+        throw std::invalid_argument{fmt::format("Top-k sketch capacity {} is out of range.", capacity_)};
+    }
+
+    // at most half full, so probes stay short
+    slots_.assign(std::bit_ceil(capacity_ * 2), EmptySlot);
+    slotMask_ = slots_.size() - 1;
+    counters_.reserve(capacity_);
+    heap_.reserve(capacity_);
+}
+
+TopKSketch TopKSketch::fromState(
+    std::size_t capacity,
+    long long int totalWeight,
+    const std::vector<Entry> &entries,
+    std::vector<long long int> frequencyCells
+){
+    TopKSketch sketch{capacity};
+    if(frequencyCells.size() != sketch.frequencyCells_.size()){
+        throw std::invalid_argument{fmt::format("Top-k sketch has {} cells instead of {}.", frequencyCells.size(), sketch.frequencyCells_.size())};
+    }
+    if(entries.size() > capacity){
+        throw std::invalid_argument{fmt::format("Top-k sketch has {} entries but a capacity of {}.", entries.size(), capacity)};
+    }
+
+    sketch.frequencyCells_ = std::move(frequencyCells);
+    for(const Entry &entry : entries){
+        const std::uint64_t valueHash{HyperLogLog::hash(entry.value)};
+        if(sketch.slots_[sketch.findSlot(valueHash, entry.value)] != EmptySlot){
+            throw std::invalid_argument{fmt::format("Top-k sketch lists '{}' twice.", entry.value)};
+        }
+        sketch.insertCounter(entry.value, valueHash, entry.count, entry.count - entry.overcount);
+    }
+    sketch.totalWeight_ = totalWeight;
+    return sketch;
+}
+
+void TopKSketch::add(std::string_view value, long long int weight){
+    totalWeight_ += weight;
+
+    const std::uint64_t valueHash{HyperLogLog::hash(value)};
+    const long long int estimate{recordFrequency(valueHash, weight)};
+
+    const std::size_t slot{findSlot(valueHash, value)};
+    if(slots_[slot] != EmptySlot){
+        Counter &counter{counters_[slots_[slot]]};
+        counter.count = estimate;
+        counter.observed += weight;
+        siftDown(counter.heapPosition);
+        return;
+    }
+
+    if(counters_.size() < capacity_){
+        insertCounter(value, valueHash, estimate, weight);
+        return;
+    }
+
+    // the tracked value with the lowest estimate makes room, unless the newcomer is rarer still
+    const std::uint32_t counterIndex{heap_.front()};
+    Counter &counter{counters_[counterIndex]};
+    if(estimate <= counter.count) return;
+
+    eraseSlot(findSlotOf(counterIndex));
+    counter.value.assign(value);
+    counter.valueHash = valueHash;
+    counter.count = estimate;
+    counter.observed = weight;
+    slots_[findSlot(valueHash, value)] = counterIndex;
+    siftDown(0);
+}
+
+void TopKSketch::merge(const TopKSketch &other){
+    if(other.capacity_ != capacity_){
+        throw std::invalid_argument{fmt::format("Cannot merge top-k sketches of capacity {} and {}.", capacity_, other.capacity_)};
+    }
+
+    std::vector<long long int> frequencyCells{frequencyCells_};
+    for(std::size_t cellIndex{0}; cellIndex < frequencyCells.size(); cellIndex++) frequencyCells[cellIndex] += other.frequencyCells_[cellIndex];
+
+    // every value tracked by either side is a candidate, ranked by its estimate over both streams
+    std::vector<Entry> candidates;
+    std::unordered_map<std::string_view, std::size_t> candidateIndex;
+    for(const TopKSketch *sketch : {static_cast<const TopKSketch *>(this), &other}){
+        for(const Counter &counter : sketch->counters_){
+            const auto [existing, isNew]{candidateIndex.emplace(counter.value, candidates.size())};
+            if(isNew){
+                candidates.push_back({counter.value, 0, -counter.observed}); // overcount holds minus the observations for now
+            }else{
+                candidates[existing->second].overcount -= counter.observed;
+            }
+        }
+    }
+
+    TopKSketch merged{capacity_};
+    merged.frequencyCells_ = std::move(frequencyCells);
+    for(Entry &candidate : candidates){
+        candidate.count = merged.estimateFrequency(HyperLogLog::hash(candidate.value));
+        candidate.overcount += candidate.count;
+    }
+
+    const std::size_t keptCount{std::min(candidates.size(), capacity_)};
+    std::partial_sort(candidates.begin(), candidates.begin() + static_cast<std::ptrdiff_t>(keptCount), candidates.end(), [](const Entry &left, const Entry &right){
+        return left.count > right.count;
+    });
+    candidates.resize(keptCount);
+
+    *this = fromState(capacity_, totalWeight_ + other.totalWeight_, candidates, std::move(merged.frequencyCells_));
+}
+
+std::vector<TopKSketch::Entry> TopKSketch::entries() const{
+    std::vector<Entry> sortedEntries;
+    sortedEntries.reserve(counters_.size());
+    for(const Counter &counter : counters_) sortedEntries.push_back({counter.value, counter.count, counter.count - counter.observed});
+
+    // ties go to the value whose count is more certain, then to the smaller value, so reports are stable
+    std::sort(sortedEntries.begin(), sortedEntries.end(), [](const Entry &left, const Entry &right){
+        if(left.count != right.count) return left.count > right.count;
+        if(left.overcount != right.overcount) return left.overcount < right.overcount;
+        return left.value < right.value;
+    });
+    return sortedEntries;
+}
+
+long long int TopKSketch::recordFrequency(std::uint64_t valueHash, long long int weight){
+    const long long int estimate{estimateFrequency(valueHash) + weight};
+
+    // conservative update: only cells below the new estimate grow, which keeps collisions from
+    // inflating the other values sharing them more than necessary
+    const std::uint64_t step{(valueHash >> 32) | 1};
+    for(std::size_t row{0}; row < Constants::ValueProfileSketchDepth; row++){
+        long long int &cell{frequencyCells_[row * Constants::ValueProfileSketchWidth + ((valueHash + row * step) & (Constants::ValueProfileSketchWidth - 1))]};
+        cell = std::max(cell, estimate);
+    }
+    return estimate;
+}
+
+long long int TopKSketch::estimateFrequency(std::uint64_t valueHash) const{
+    // the rows' cells are picked by double hashing, h1 + row * h2, from the halves of one hash
+    const std::uint64_t step{(valueHash >> 32) | 1};
+    long long int estimate{std::numeric_limits<long long int>::max()};
+    for(std::size_t row{0}; row < Constants::ValueProfileSketchDepth; row++){
+        estimate = std::min(estimate, frequencyCells_[row * Constants::ValueProfileSketchWidth + ((valueHash + row * step) & (Constants::ValueProfileSketchWidth - 1))]);
+    }
+    return estimate;
+}
+
+void TopKSketch::insertCounter(std::string_view value, std::uint64_t valueHash, long long int count, long long int observed){
+    const std::uint32_t counterIndex{static_cast<std::uint32_t>(counters_.size())};
+    counters_.push_back({std::string{value}, valueHash, count, observed, 0});
+    slots_[findSlot(valueHash, value)] = counterIndex;
+    pushHeap(counterIndex);
+}
+
+std::size_t TopKSketch::findSlot(std::uint64_t valueHash, std::string_view value) const{
+    std::size_t slot{valueHash & slotMask_};
+    while(slots_[slot] != EmptySlot){
+        const Counter &counter{counters_[slots_[slot]]};
+        if(counter.valueHash == valueHash && counter.value == value) return slot;
+        slot = (slot + 1) & slotMask_;
+    }
+    return slot;
+}
+
+std::size_t TopKSketch::findSlotOf(std::size_t counterIndex) const{
+    std::size_t slot{counters_[counterIndex].valueHash & slotMask_};
+    while(slots_[slot] != counterIndex) slot = (slot + 1) & slotMask_;
+    return slot;
+}
+
+void TopKSketch::eraseSlot(std::size_t slot){
+    // shift later entries of the probe sequence back, so no lookup ever stops at the hole early
+    std::size_t hole{slot};
+    for(std::size_t next{(hole + 1) & slotMask_}; slots_[next] != EmptySlot; next = (next + 1) & slotMask_){
+        const std::size_t home{counters_[slots_[next]].valueHash & slotMask_};
+        if(((next - home) & slotMask_) >= ((next - hole) & slotMask_)){
+            slots_[hole] = slots_[next];
+            hole = next;
+        }
+    }
+    slots_[hole] = EmptySlot;
+}
+
+void TopKSketch::pushHeap(std::size_t counterIndex){
+    counters_[counterIndex].heapPosition = heap_.size();
+    heap_.push_back(static_cast<std::uint32_t>(counterIndex));
+    siftUp(heap_.size() - 1);
+}
+
+void TopKSketch::siftUp(std::size_t heapPosition){
+    while(heapPosition > 0){
+        const std::size_t parent{(heapPosition - 1) / 2};
+        if(counters_[heap_[parent]].count <= counters_[heap_[heapPosition]].count) return;
+        swapHeapEntries(parent, heapPosition);
+        heapPosition = parent;
+    }
+}
+
+void TopKSketch::siftDown(std::size_t heapPosition){
+    while(true){
+        std::size_t lowest{heapPosition};
+        for(const std::size_t child : {2 * heapPosition + 1, 2 * heapPosition + 2}){
+            if(child < heap_.size() && counters_[heap_[child]].count < counters_[heap_[lowest]].count) lowest = child;
+        }
+        if(lowest == heapPosition) return;
+        swapHeapEntries(lowest, heapPosition);
+        heapPosition = lowest;
+    }
+}
+
+void TopKSketch::swapHeapEntries(std::size_t left, std::size_t right){
+    std::swap(heap_[left], heap_[right]);
+    counters_[heap_[left]].heapPosition = left;
+    counters_[heap_[right]].heapPosition = right;
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "constants.hpp"
+
+// Fixed memory estimate of the most frequent values of a stream, a Count-Min sketch (Cormode and
+// Muthukrishnan, with conservative update) in front of a Space-Saving style set of counters.
+//
+// The Count-Min sketch remembers an upper bound of every value's count, never an underestimate,
+// in depth rows of width cells. At most capacity values are tracked by name; a value that is not
+// among them replaces the tracked value with the lowest estimate once its own estimate is higher.
+// Because the estimate covers the value's whole history, a placeholder that is rare next to a
+// million distinct values still rises into the set as it repeats, where plain Space-Saving would
+// keep evicting it. Each tracked value also counts what it was seen since it was admitted, a lower
+// bound of its true count.
+//
+// Two sketches of the same shape merge into the sketch of their combined streams by adding the
+// cells, which lets partial scans be combined. Once capacity values are tracked, adding values
+// allocates nothing unless a value is longer than the one it replaces.
+class TopKSketch{
+public:
+    struct Entry{
+        std::string value;
+        long long int count;     // upper bound of the true count
+        long long int overcount; // count minus overcount is a lower bound
+    };
+
+    explicit TopKSketch(std::size_t capacity = Constants::ValueProfileCapacity);
+
+    // restores a sketch from the state of another one, e.g. written into a partial result
+    static TopKSketch fromState(
+        std::size_t capacity,
+        long long int totalWeight,
+        const std::vector<Entry> &entries,
+        std::vector<long long int> frequencyCells
+    );
+
+    void add(std::string_view value, long long int weight = 1);
+    void merge(const TopKSketch &other);
+
+    std::vector<Entry> entries() const; // most frequent first
+
+    std::size_t capacity() const{ return capacity_; }
+    long long int totalWeight() const{ return totalWeight_; }
+    const std::vector<long long int> &frequencyCells() const{ return frequencyCells_; }
+
+private:
+    struct Counter{
+        std::string value;
+        std::uint64_t valueHash;
+        long long int count;    // the sketch's estimate when last seen
+        long long int observed; // added since it was admitted
+        std::size_t heapPosition;
+    };
+
+    long long int recordFrequency(std::uint64_t valueHash, long long int weight); // returns the new estimate
+    long long int estimateFrequency(std::uint64_t valueHash) const;
+
+    void insertCounter(std::string_view value, std::uint64_t valueHash, long long int count, long long int observed);
+
+    std::size_t findSlot(std::uint64_t valueHash, std::string_view value) const; // of the value, or of the empty slot ending its probe
+    std::size_t findSlotOf(std::size_t counterIndex) const;
+    void eraseSlot(std::size_t slot);
+
+    void pushHeap(std::size_t counterIndex);
+    void siftUp(std::size_t heapPosition);
+    void siftDown(std::size_t heapPosition);
+    void swapHeapEntries(std::size_t left, std::size_t right);
+
+    static constexpr std::uint32_t EmptySlot{0xffffffff};
+
+private:
+    std::size_t capacity_;
+    long long int totalWeight_{0};
+
+    std::vector<long long int> frequencyCells_; // ValueProfileSketchDepth rows of ValueProfileSketchWidth
+
+    std::vector<Counter> counters_;
+    std::vector<std::uint32_t> heap_;  // counter indices, lowest count on top
+    std::vector<std::uint32_t> slots_; // open addressing with linear probing, counter indices by value hash
+    std::size_t slotMask_;
+};
@@ -0,0 +1,218 @@
+#include "typerule.hpp"
+
+#include <fmt/core.h>
+
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <stdexcept>
+
+namespace{
+
+    // two digit or four digit unsigned field; returns -1 if any character is not a digit
+    int parseDigits(std::string_view text, std::size_t position, std::size_t count){
+        if(position + count > text.size()) return -1;
+
+        int value{0};
+        for(std::size_t index{position}; index < position + count; index++){
+            const char character{text[index]};
+            if(character < '0' || character > '9') return -1;
+            value = value * 10 + (character - '0');
+        }
+        return value;
+    }
+
+    bool isLeapYear(int year){
+        return (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
+    }
+
+    int daysInMonth(int year, int month){
+        constexpr int monthLengths[12]{31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+        return month == 2 && isLeapYear(year) ? 29 : monthLengths[month - 1];
+    }
+
+    // days from 1970-01-01 to the given civil date (proleptic Gregorian calendar)
+    std::int64_t daysFromCivil(int year, int month, int day){
+        year -= month <= 2;
+        const std::int64_t era{(year >= 0 ? year : year - 399) / 400};
+        const std::int64_t yearOfEra{year - era * 400};
+        const std::int64_t dayOfYear{(153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1};
+        const std::int64_t dayOfEra{yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear};
+        return era * 146097 + dayOfEra - 719468;
+    }
+
+    // YYYY-MM-DD prefix of text; returns the day count and leaves the rest to the caller
+    std::optional<std::int64_t> parseDatePrefix(std::string_view text){
+        if(text.size() < 10 || text[4] != '-' || text[7] != '-') return std::nullopt;
+
+        const int year{parseDigits(text, 0, 4)};
+        const int month{parseDigits(text, 5, 2)};
+        const int day{parseDigits(text, 8, 2)};
+        if(year < 0 || month < 1 || month > 12 || day < 1 || day > daysInMonth(year, month)) return std::nullopt;
+
+        return daysFromCivil(year, month, day);
+    }
+
+} // namespace
+
+TypeRule::TypeRule(std::string_view specification)
+    : specification_{specification}
+{
+    const std::size_t separatorPosition{specification.find(':')};
+    const std::string_view typeName{specification.substr(0, separatorPosition)};
+    const std::string_view argument{
+        separatorPosition == std::string_view::npos ? std::string_view{} : specification.substr(separatorPosition + 1)
+    };
+
+    const auto fail{[&specification](const std::string &message){
+        throw std::invalid_argument{fmt::format("Invalid type rule '{}': {}.", specification, message)};
+    }};
+
+    if(typeName == "integer") kind_ = Kind::INTEGER;
+    else if(typeName == "float") kind_ = Kind::FLOAT;
+    else if(typeName == "date") kind_ = Kind::DATE;
+    else if(typeName == "timestamp") kind_ = Kind::TIMESTAMP;
+    else if(typeName == "enum") kind_ = Kind::ENUM;
+    else fail("type must be integer, float, date, timestamp or enum");
+
+    if(kind_ == Kind::ENUM){
+        std::string_view remaining{argument};
+        while(!remaining.empty()){
+            const std::size_t barPosition{remaining.find('|')};
+            enumValues_.emplace_back(remaining.substr(0, barPosition));
+            if(barPosition == std::string_view::npos) break;
+            remaining.remove_prefix(barPosition + 1);
+        }
+
+        std::sort(enumValues_.begin(), enumValues_.end());
+        enumValues_.erase(std::unique(enumValues_.begin(), enumValues_.end()), enumValues_.end());
+        if(enumValues_.empty()) fail("enum needs at least one value");
+        return;
+    }
+
+    if(argument.empty()) return;
+
+    const std::size_t rangePosition{argument.find("..")};
+    if(rangePosition == std::string_view::npos) fail("bounds must be written as min..max");
+
+    const std::string_view minimumText{argument.substr(0, rangePosition)};
+    const std::string_view maximumText{argument.substr(rangePosition + 2)};
+
+    const auto parseBound{[this, &fail](std::string_view boundText, std::optional<std::int64_t> &integralBound, std::optional<double> &floatBound){
+        if(boundText.empty()) return;
+
+        switch(kind_){
+            case Kind::INTEGER: integralBound = parseInteger(boundText); break;
+            case Kind::DATE: integralBound = parseDate(boundText); break;
+            case Kind::TIMESTAMP: integralBound = parseTimestamp(boundText); break;
+            case Kind::FLOAT: floatBound = parseFloat(boundText); break;
+            default: break;
+        }
+
+        if(!integralBound.has_value() && !floatBound.has_value()){
+            fail(fmt::format("'{}' is not a valid bound for this type", boundText));
+        }
+    }};
+
+    parseBound(minimumText, integralMinimum_, floatMinimum_);
+    parseBound(maximumText, integralMaximum_, floatMaximum_);
+}
+
+bool TypeRule::accepts(std::string_view cell) const{
+    const auto isWithinBounds{[](const auto value, const auto &minimum, const auto &maximum){
+        return (!minimum.has_value() || value >= *minimum) && (!maximum.has_value() || value <= *maximum);
+    }};
+
+    switch(kind_){
+        case Kind::NONE:
+            return true;
+        case Kind::INTEGER:{
+            const std::optional<std::int64_t> value{parseInteger(cell)};
+            return value.has_value() && isWithinBounds(*value, integralMinimum_, integralMaximum_);
+        }
+        case Kind::FLOAT:{
+            const std::optional<double> value{parseFloat(cell)};
+            return value.has_value() && isWithinBounds(*value, floatMinimum_, floatMaximum_);
+        }
+        case Kind::DATE:{
+            const std::optional<std::int64_t> value{parseDate(cell)};
+            return value.has_value() && isWithinBounds(*value, integralMinimum_, integralMaximum_);
+        }
+        case Kind::TIMESTAMP:{
+            const std::optional<std::int64_t> value{parseTimestamp(cell)};
+            return value.has_value() && isWithinBounds(*value, integralMinimum_, integralMaximum_);
+        }
+        case Kind::ENUM:
+            return std::binary_search(
+                enumValues_.begin(), enumValues_.end(), cell,
+                [](const auto &left, const auto &right){ return std::string_view{left} < std::string_view{right}; }
+            );
+    }
+    return true;
+}
+
+std::optional<std::int64_t> TypeRule::parseInteger(std::string_view text){
+    if(!text.empty() && text.front() == '+') text.remove_prefix(1);
+
+    std::int64_t value{0};
+    const auto [end, error]{std::from_chars(text.data(), text.data() + text.size(), value)};
+    if(error != std::errc{} || end != text.data() + text.size() || text.empty()) return std::nullopt;
+    return value;
+}
+
+std::optional<double> TypeRule::parseFloat(std::string_view text){
+    if(!text.empty() && text.front() == '+') text.remove_prefix(1);
+
+    double value{0.0};
+    const auto [end, error]{std::from_chars(text.data(), text.data() + text.size(), value, std::chars_format::general)};
+    if(error != std::errc{} || end != text.data() + text.size() || text.empty() || !std::isfinite(value)) return std::nullopt;
+    return value;
+}
+
+std::optional<std::int64_t> TypeRule::parseDate(std::string_view text){
+    if(text.size() != 10) return std::nullopt;
+    return parseDatePrefix(text);
+}
+
+std::optional<std::int64_t> TypeRule::parseTimestamp(std::string_view text){
+    const std::optional<std::int64_t> days{parseDatePrefix(text)};
+    if(!days.has_value() || text.size() < 16 || (text[10] != 'T' && text[10] != ' ') || text[13] != ':') return std::nullopt;
+
+    const int hour{parseDigits(text, 11, 2)};
+    const int minute{parseDigits(text, 14, 2)};
+    if(hour < 0 || hour > 23 || minute < 0 || minute > 59) return std::nullopt;
+
+    std::size_t position{16};
+    int second{0};
+    if(position < text.size() && text[position] == ':'){
+        second = parseDigits(text, position + 1, 2);
+        if(second < 0 || second > 60) return std::nullopt; // 60 allows a leap second
+        position += 3;
+
+        if(position < text.size() && (text[position] == '.' || text[position] == ',')){
+            const std::size_t fractionStart{++position};
+            while(position < text.size() && text[position] >= '0' && text[position] <= '9') position++;
+            if(position == fractionStart) return std::nullopt;
+        }
+    }
+
+    int offsetSeconds{0};
+    if(position < text.size()){
+        const char designator{text[position]};
+        if(designator == 'Z' && position + 1 == text.size()){
+            position++;
+        }else if(designator == '+' || designator == '-'){
+            const int offsetHours{parseDigits(text, position + 1, 2)};
+            std::size_t minutesPosition{position + 3};
+            if(minutesPosition < text.size() && text[minutesPosition] == ':') minutesPosition++;
+            const int offsetMinutes{minutesPosition < text.size() ? parseDigits(text, minutesPosition, 2) : 0};
+            if(offsetHours < 0 || offsetHours > 23 || offsetMinutes < 0 || offsetMinutes > 59) return std::nullopt;
+
+            offsetSeconds = (offsetHours * 3600 + offsetMinutes * 60) * (designator == '-' ? -1 : 1);
+            position = minutesPosition < text.size() ? minutesPosition + 2 : minutesPosition;
+        }
+    }
+    if(position != text.size()) return std::nullopt;
+
+    return *days * 86400 + hour * 3600 + minute * 60 + second - offsetSeconds;
+}
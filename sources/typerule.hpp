@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// A per-column type constraint such as "integer:0..120" or "date:2000-01-01..". Cells are
+// parsed straight from their string_view with std::from_chars and hand written ISO-8601
+// readers, so checking a rule never allocates.
+//
+// Specification syntax: <type>[:<min>..<max>] where either bound may be left out, with
+// types integer, float, date (YYYY-MM-DD) and timestamp (YYYY-MM-DDTHH:MM[:SS[.fff]][Z|+HH:MM]),
+// or enum:<value>|<value>|... for a closed set of values.
+class TypeRule{
+public:
+    enum class Kind{
+        NONE,
+        INTEGER,
+        FLOAT,
+        DATE,
+        TIMESTAMP,
+        ENUM
+    };
+
+    TypeRule() = default;
+    explicit TypeRule(std::string_view specification);
+
+    bool empty() const{ return kind_ == Kind::NONE; }
+    const std::string &specification() const{ return specification_; }
+
+    bool accepts(std::string_view cell) const;
+
+    static std::optional<std::int64_t> parseInteger(std::string_view text);
+    static std::optional<double> parseFloat(std::string_view text);
+    static std::optional<std::int64_t> parseDate(std::string_view text);      // days since 1970-01-01
+    static std::optional<std::int64_t> parseTimestamp(std::string_view text); // seconds since 1970-01-01T00:00:00Z
+
+private:
+    Kind kind_{Kind::NONE};
+    std::string specification_;
+
+    // bounds are kept as the parsed representation of the kind: integer, days or seconds use the
+    // integral pair, float uses the floating pair
+    std::optional<std::int64_t> integralMinimum_;
+    std::optional<std::int64_t> integralMaximum_;
+    std::optional<double> floatMinimum_;
+    std::optional<double> floatMaximum_;
+
+    std::vector<std::string> enumValues_; // sorted
+};
@@ -1,5 +1,9 @@
 #include "nanalyzer.hpp"
 
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <cmath>
 #include <iostream>
 #include <limits>
 #include <sstream>
@@ -31,10 +35,145 @@ NaNalyzer::DelimitedStringList NaNalyzer::splitString(
 }
 
 bool NaNalyzer::isCellValid(
-    const std::string &string, 
-    const InvalidValueSet &invalidValues
+    std::string_view cell,
+    const Column &column
 ) const{
-    return !string.empty() && invalidValues.find(string) == invalidValues.end();
+    if(cell.empty() || column.invalidValues.find(cell) != column.invalidValues.end()) return false;
+    if(!column.typeRule.accepts(cell)) return false;
+    return column.invalidPatternMatcher.empty() || !column.invalidPatternMatcher.matches(cell);
+}
+
+bool NaNalyzer::isRowSelected(const RowFieldList &rowFields) const{
+    return std::all_of(rowFilters_.begin(), rowFilters_.end(), [&rowFields](const RowFilter &rowFilter){
+        const int columnOffset{rowFilter.columnOffset()};
+        return rowFilter.accepts(columnOffset < static_cast<int>(rowFields.size()) ? rowFields[columnOffset] : std::string_view{});
+    });
+}
+
+bool NaNalyzer::looksLikePlaceholder(std::string_view value){
+    // spellings of "no value" seen in exports, compared after lowercasing and unwrapping "(null)", "<none>" or "#N/A"
+    static constexpr std::array<std::string_view, 18> placeholderWords{
+        "null", "nil", "none", "na", "n/a", "n.a.", "nan", "undefined", "unknown", "missing",
+        "empty", "blank", "void", "tbd", "not available", "not applicable", "no data", "default"
+    };
+
+    std::string normalized;
+    for(const char character : value){
+        normalized += static_cast<char>(std::tolower(static_cast<unsigned char>(character)));
+    }
+    const std::size_t first{normalized.find_first_not_of(" \t")};
+    if(first == std::string::npos) return false; // blank cells are invalid anyway
+    normalized = normalized.substr(first, normalized.find_last_not_of(" \t") - first + 1);
+
+    std::string_view unwrapped{normalized};
+    if(unwrapped.size() > 1 && unwrapped.front() == '#') unwrapped.remove_prefix(1);
+    for(const std::string_view brackets : {"()", "<>", "[]", "{}"}){
+        if(unwrapped.size() > 2 && unwrapped.front() == brackets[0] && unwrapped.back() == brackets[1]){
+            unwrapped = unwrapped.substr(1, unwrapped.size() - 2);
+        }
+    }
+    if(std::find(placeholderWords.begin(), placeholderWords.end(), unwrapped) != placeholderWords.end()) return true;
+
+    // nothing but punctuation, e.g. "-", "?" or "***"
+    if(std::none_of(normalized.begin(), normalized.end(), [](const char character){ return std::isalnum(static_cast<unsigned char>(character)) != 0; })){
+        return true;
+    }
+
+    // one symbol repeated between separators, e.g. "0000-00-00", "00:00:00", "99999" or "xxx"
+    std::string symbols;
+    for(const char character : normalized){
+        if(character != '-' && character != '/' && character != ':' && character != ' ') symbols += character;
+    }
+    const bool isRepeated{!symbols.empty() && symbols.find_first_not_of(symbols.front()) == std::string::npos};
+    if(!isRepeated) return false;
+    return (symbols.front() == '0' && symbols.size() >= 3) || (symbols.front() == '9' && symbols.size() >= 4) || (symbols.front() == 'x' && symbols.size() >= 2);
+}
+
+std::vector<std::string> NaNalyzer::suggestInvalidValues(const ValueProfile &valueProfile) const{
+    const Column &column{columns_.at(valueProfile.fieldNumber)};
+
+    // only values the sketch has certainly seen repeatedly, and that do not already count as invalid
+    std::vector<std::string> suggestions;
+    for(const TopKSketch::Entry &entry : valueProfile.sketch.entries()){
+        if(entry.count - entry.overcount < Constants::PlaceholderMinimumCount) continue;
+        if(!isCellValid(entry.value, column) || !looksLikePlaceholder(entry.value)) continue;
+        suggestions.push_back(entry.value);
+    }
+    return suggestions;
+}
+
+std::size_t NaNalyzer::internGroupKey(std::string_view key){
+    const auto existingGroup{groupIndex_.find(key)};
+    if(existingGroup != groupIndex_.end()) return existingGroup->second;
+
+    const std::size_t groupIndex{groupKeys_.size()};
+    const GroupKey storedKey{groupKeyArena_.store(key)};
+
+    groupIndex_.emplace(storedKey, groupIndex);
+    groupKeys_.push_back(storedKey);
+    groupRowCounts_.push_back(0);
+    groupValidCounts_.resize(groupValidCounts_.size() + columnCombinationsToCheck_.size(), 0);
+
+    return groupIndex;
+}
+
+void NaNalyzer::recordDistinctEntity(std::string_view key, const std::vector<char> &satisfiedCombinations){
+    if(distinctMode_ == DistinctMode::HYPERLOGLOG){
+        const std::uint64_t keyHash{HyperLogLog::hash(key)};
+        distinctEntitySketch_.add(keyHash);
+        for(std::size_t combinationIndex{0}; combinationIndex < satisfiedCombinations.size(); combinationIndex++){
+            if(satisfiedCombinations[combinationIndex]) distinctValidSketches_[combinationIndex].add(keyHash);
+        }
+        return;
+    }
+
+    auto existingEntity{distinctIndex_.find(key)};
+    if(existingEntity == distinctIndex_.end()){
+        existingEntity = distinctIndex_.emplace(distinctKeyArena_.store(key), distinctIndex_.size()).first;
+        distinctSatisfied_.resize(distinctSatisfied_.size() + satisfiedCombinations.size(), 0);
+    }
+
+    char *entitySatisfied{&distinctSatisfied_[existingEntity->second * satisfiedCombinations.size()]};
+    for(std::size_t combinationIndex{0}; combinationIndex < satisfiedCombinations.size(); combinationIndex++){
+        entitySatisfied[combinationIndex] |= satisfiedCombinations[combinationIndex];
+    }
+}
+
+void NaNalyzer::concludeDistinctCounts(){
+    const std::size_t combinationCount{columnCombinationsToCheck_.size()};
+    distinctValidCounts_.assign(combinationCount, 0);
+
+    if(distinctMode_ == DistinctMode::HYPERLOGLOG){
+        distinctEntityCount_ = std::llround(distinctEntitySketch_.estimate());
+        for(std::size_t combinationIndex{0}; combinationIndex < combinationCount; combinationIndex++){
+            // estimates carry independent errors, never report more satisfying entities than entities
+            distinctValidCounts_[combinationIndex] = std::min(
+                std::llround(distinctValidSketches_[combinationIndex].estimate()),
+                distinctEntityCount_
+            );
+        }
+        return;
+    }
+
+    distinctEntityCount_ = static_cast<long long int>(distinctIndex_.size());
+    for(std::size_t entityIndex{0}; entityIndex < distinctIndex_.size(); entityIndex++){
+        for(std::size_t combinationIndex{0}; combinationIndex < combinationCount; combinationIndex++){
+            distinctValidCounts_[combinationIndex] += distinctSatisfied_[entityIndex * combinationCount + combinationIndex];
+        }
+    }
+}
+
+NaNalyzer::FilePath NaNalyzer::deriveSplitOutputPath(const std::string &suffix) const{
+    const std::size_t extensionPosition{csvFilePath_.rfind('.')};
+    const std::size_t separatorPosition{csvFilePath_.find_last_of("/\\")};
+
+    const bool hasExtension{
+        extensionPosition != std::string::npos
+        && (separatorPosition == std::string::npos || extensionPosition > separatorPosition)
+    };
+
+    if(!hasExtension) return fmt::format("{}_{}.csv", csvFilePath_, suffix);
+    return fmt::format("{}_{}{}", csvFilePath_.substr(0, extensionPosition), suffix, csvFilePath_.substr(extensionPosition));
 }
 
 void NaNalyzer::clearInputBuffer() const{
@@ -45,13 +184,95 @@ void NaNalyzer::clearInputBuffer() const{
     std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
 }
 
+NaNalyzer::DelimitedStringList NaNalyzer::splitCombinationList(const std::string &string) const{
+    DelimitedStringList combinationStrings;
+    int parenthesisDepth{0};
+    std::size_t start{0};
+
+    for(std::size_t position{0}; position <= string.size(); ++position){
+        if(position < string.size()){
+            if(string[position] == '(') parenthesisDepth += 1;
+            if(string[position] == ')') parenthesisDepth -= 1;
+            if(string[position] != ',' || parenthesisDepth > 0) continue;
+        }
+
+        const std::string token{string.substr(start, position - start)};
+        const std::size_t firstNonWhitespace{token.find_first_not_of(" \t\n\r")};
+        if(firstNonWhitespace == std::string::npos){
+            combinationStrings.emplace_back();
+        }else{
+            const std::size_t lastNonWhitespace{token.find_last_not_of(" \t\n\r")};
+            combinationStrings.push_back(token.substr(firstNonWhitespace, lastNonWhitespace - firstNonWhitespace + 1));
+        }
+        start = position + 1;
+    }
+
+    return combinationStrings;
+}
+
+NaNalyzer::ColumnCombination NaNalyzer::parseCombinationString(const std::string &combinationString) const{
+    const auto checkFieldNumber{[this](int fieldNumber){
+        const int zeroBasedIndex{fieldNumber - 1};
+
+        if(zeroBasedIndex < 0 || zeroBasedIndex >= static_cast<int>(headers_.size())){
+            throw std::runtime_error{fmt::format("Field {} is out of range.", fieldNumber)};
+        }
+
+        if(!columns_.contains(fieldNumber)){
+            throw std::runtime_error{fmt::format("Field {} not in selected columns.", fieldNumber)};
+        }
+    }};
+
+    if(RuleExpression::isExpressionSyntax(combinationString)){
+        ColumnCombination combination{RuleExpression::parse(combinationString)};
+        for(const ColumnOffset columnOffset : combination.columnOffsets()){
+            try{
+                checkFieldNumber(columnOffset + 1);
+            }catch(const std::exception &exception){
+                throw std::runtime_error{fmt::format("Invalid field in combination '{}': {}", combinationString, exception.what())};
+            }
+        }
+        return combination;
+    }
+
+    std::vector<ColumnDisjunction> clauses;
+
+    for(const std::string &andPart : splitString(combinationString, ':')){
+        ColumnDisjunction clause;
+
+        for(const std::string &orPart : splitString(andPart, '/')){
+            if(orPart.empty()) continue;
+
+            try{
+                int fieldNumber{std::stoi(orPart)};
+                checkFieldNumber(fieldNumber);
+                clause.push_back(fieldNumber - 1);
+            }catch(const std::exception &exception){
+                throw std::runtime_error{fmt::format("Invalid field in combination '{}': {}", orPart, exception.what())};
+            }
+        }
+
+        if(!clause.empty()){
+            std::sort(clause.begin(), clause.end());
+            clause.erase(std::unique(clause.begin(), clause.end()), clause.end());
+            clauses.push_back(std::move(clause));
+        }
+    }
+
+    return RuleExpression::fromClauses(clauses);
+}
+
 std::string NaNalyzer::formatCombinationForDisplay(
     const ColumnCombination &combination
 ) const{
+    // rules the original syntax can express are shown in it, so names and reports stay the same
+    const std::optional<std::vector<ColumnDisjunction>> clauses{combination.clauses()};
+    if(!clauses.has_value()) return combination.toString();
+
     std::vector<std::string> clauseStrings;
-    clauseStrings.reserve(combination.size());
+    clauseStrings.reserve(clauses->size());
 
-    for(const auto &disjunction : combination){
+    for(const auto &disjunction : clauses.value()){
         std::vector<int> displayIndices;
         displayIndices.reserve(disjunction.size());
 
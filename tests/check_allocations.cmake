@@ -0,0 +1,54 @@
+# Fails when a scan allocates on the heap once the first data rows have warmed up its buffers.
+#
+# Usage: cmake -DCHECKER=<instrumented binary> -DFIXTURE=<csv> -DWORK_DIR=<dir> -P check_allocations.cmake
+#
+# The fixture's rows are repeated until the scan passes several reorderings of its combinations
+# (every 4096 rows) after the 1024 warm-up rows.
+
+foreach(variable CHECKER FIXTURE WORK_DIR)
+    if(NOT DEFINED ${variable})
+        message(FATAL_ERROR "${variable} is not set.")
+    endif()
+endforeach()
+
+file(STRINGS "${FIXTURE}" fixtureLines)
+list(GET fixtureLines 0 header)
+list(REMOVE_AT fixtureLines 0)
+string(REPLACE ";" "\n" rows "${fixtureLines}")
+set(rows "${rows}\n")
+
+# 2^10 copies of the 16 fixture rows
+foreach(doubling RANGE 1 10)
+    string(APPEND rows "${rows}")
+endforeach()
+
+set(csvPath "${WORK_DIR}/allocations_repeated.csv")
+file(WRITE "${csvPath}" "${header}\n${rows}")
+
+set(combinationSets
+    "1:2:3/4,4/5"
+    "2 & (3 | !4) & atleast(2, 3, 4, 5),atleast(3, 1, 2, 3, 4, 5),!2 | !5"
+)
+
+foreach(combinations IN LISTS combinationSets)
+    execute_process(
+        COMMAND "${CHECKER}" --csv "${csvPath}" --quote "\"" -b "${combinations}" --stats --silent
+        RESULT_VARIABLE exitCode
+        OUTPUT_VARIABLE output
+        ERROR_VARIABLE errorOutput
+    )
+
+    if(NOT exitCode EQUAL 0)
+        message(FATAL_ERROR "-b ${combinations} exited with ${exitCode}:\n${output}${errorOutput}")
+    endif()
+
+    if(NOT errorOutput MATCHES "data rows: ([0-9]+) allocations, ([0-9]+) bytes")
+        message(FATAL_ERROR "-b ${combinations} reported no allocation counts, is the binary built with ALLOCATION_ACCOUNTING?\n${errorOutput}")
+    endif()
+
+    if(NOT CMAKE_MATCH_1 EQUAL 0)
+        message(FATAL_ERROR "-b ${combinations} allocated ${CMAKE_MATCH_1} times (${CMAKE_MATCH_2} bytes) in the data rows:\n${errorOutput}")
+    endif()
+
+    message(STATUS "-b ${combinations}: no data row allocations")
+endforeach()